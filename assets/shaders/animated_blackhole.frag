@@ -1,11 +1,45 @@
 #version 330 core
-out vec4 FragColor;
+#ifdef RAY_STATS_ATOMICS
+#extension GL_ARB_shader_atomic_counters : require
+#endif
+#ifdef RAY_STATS_ATOMIC_OPS
+#extension GL_ARB_shader_atomic_counter_ops : require
+#endif
+layout(location = 0) out vec4 FragColor;
+#ifdef MULTIVIEW
+// from multiview.geom: one layer per view
+in vec2 gNDC;
+flat in int gView;
+#define vNDC gNDC
+#else
 in vec2 vNDC;
-
-uniform mat4 uInvVP;
-uniform vec2 uResolution;
-uniform float uTime;
-uniform vec3 uCameraPos;
+#endif
+#ifdef WARP_MAP
+// FragColor = vec4(exit position, transmittance), see WarpLens in warp_lens.h
+layout(location = 1) out vec4 WarpDir;    // exit direction, disk weight of crossing 0
+layout(location = 2) out vec4 WarpEmit;   // static emission (corona), disk weight of crossing 1
+layout(location = 3) out vec4 WarpDisk0;  // disk crossing 0: r_phys, azimuth, photon dir xz
+layout(location = 4) out vec4 WarpDisk1;  // disk crossing 1
+#endif
+
+// per-frame data, see FrameData in frame_ring.h
+layout(std140) uniform FrameData {
+    mat4  uInvVP;
+    vec3  uCameraPos;
+    float uTime;
+    vec2  uResolution;
+};
+
+#ifdef MULTIVIEW
+// per-view data, see MultiView::ViewData in multiview.h
+layout(std140) uniform ViewData {
+    mat4 uViewInvVP[6];
+    vec4 uViewCamPos[6];
+    int  uViewCount;
+};
+#define uInvVP     uViewInvVP[gView]
+#define uCameraPos uViewCamPos[gView].xyz
+#endif
 
 // ==================== Physical params ====================
 const float RS         = 0.8;
@@ -14,7 +48,9 @@ const float R_DISK_IN  = 0.9 * RS;
 const float R_DISK_OUT = 12.0 * RS;
 
 // Integrator controls
-const int   N_STEPS    = 1200;
+#ifndef N_STEPS
+#define N_STEPS 1200   // RAY_STATS builds get RayStats::MAX_STEPS from the host
+#endif
 const float LAMBDA_MAX = 120.0;
 const float H_BASE     = 0.04;
 
@@ -29,6 +65,67 @@ const float HOTSIGMA_A   = 0.20;
 const float HOTSIGMA_R   = 0.7*RS;
 const float HOT_R0       = 2.2*RS;
 
+#ifdef WARP_MAP
+// Lensing region; rays are recorded where they finally leave it.
+// Keep in sync with WarpLens::LENS_RADIUS and lens_compose.frag
+const float R_LENS = 12.0 * RS;
+
+// The disk is animated, so it is not baked: the first WARP_CROSSINGS
+// passes through it are stored and lens_compose.frag evaluates
+// diskModulation() for the current time. Per crossing the sums are
+// (w x.x, w x.z, w r_phys, w) and w * photon direction, w = diskWeight().
+const int WARP_CROSSINGS = 2;
+
+vec3 gExitPos = vec3(0.0);
+vec3 gExitDir = vec3(0.0, 0.0, -1.0);
+vec3 gEmit    = vec3(0.0);
+vec4 gCross[WARP_CROSSINGS]    = vec4[WARP_CROSSINGS](vec4(0.0), vec4(0.0));
+vec3 gCrossDir[WARP_CROSSINGS] = vec3[WARP_CROSSINGS](vec3(0.0), vec3(0.0));
+#endif
+
+// ==================== Cost counters ====================
+// Termination reasons, keep in sync with RayStats::Reason
+const uint REASON_EXHAUSTED     = 0u; // ran out of N_STEPS
+const uint REASON_PHOTON_SPHERE = 1u;
+const uint REASON_HORIZON       = 2u;
+const uint REASON_LAMBDA_MAX    = 3u;
+const uint REASON_ESCAPED       = 4u;
+
+#ifdef RAY_STATS
+// attachment 1: uvec4(iterations, termination reason, rhs evaluations, 0)
+layout(location = 1) out uvec4 StatsOut;
+
+uint gRhsEvals = 0u;
+
+#ifdef RAY_STATS_ATOMICS
+// pixel count per termination reason, keep in sync with RayStats::Counter
+layout(binding = 0, offset = 0)  uniform atomic_uint acExhausted;
+layout(binding = 0, offset = 4)  uniform atomic_uint acPhotonSphere;
+layout(binding = 0, offset = 8)  uniform atomic_uint acHorizon;
+layout(binding = 0, offset = 12) uniform atomic_uint acLambdaMax;
+layout(binding = 0, offset = 16) uniform atomic_uint acEscaped;
+#ifdef RAY_STATS_ATOMIC_OPS
+layout(binding = 0, offset = 20) uniform atomic_uint acTotalSteps;
+layout(binding = 0, offset = 24) uniform atomic_uint acTotalRhsEvals;
+#endif
+#endif
+
+void writeStats(int steps, uint reason) {
+    StatsOut = uvec4(uint(steps), reason, gRhsEvals, 0u);
+#ifdef RAY_STATS_ATOMICS
+    if      (reason == REASON_EXHAUSTED)     atomicCounterIncrement(acExhausted);
+    else if (reason == REASON_PHOTON_SPHERE) atomicCounterIncrement(acPhotonSphere);
+    else if (reason == REASON_HORIZON)       atomicCounterIncrement(acHorizon);
+    else if (reason == REASON_LAMBDA_MAX)    atomicCounterIncrement(acLambdaMax);
+    else                                     atomicCounterIncrement(acEscaped);
+#ifdef RAY_STATS_ATOMIC_OPS
+    atomicCounterAddARB(acTotalSteps, uint(steps));
+    atomicCounterAddARB(acTotalRhsEvals, gRhsEvals);
+#endif
+#endif
+}
+#endif
+
 // ==================== Utility / background ====================
 float hash31(vec3 p) {
     p = fract(p * 0.3183099 + 0.1);
@@ -76,6 +173,9 @@ ABVals metricAB(float rho) {
 struct RHS { vec3 dx; vec3 dp; };
 
 RHS rhs(vec3 x, vec3 p) {
+#ifdef RAY_STATS
+    gRhsEvals += 1u;
+#endif
     float rho = length(x);
     ABVals m = metricAB(rho);
     float invB2 = 1.0 / (m.B * m.B);
@@ -116,8 +216,7 @@ void rk4(inout vec3 x, inout vec3 p, float h) {
 }
 
 // ==================== Relativistic helpers ====================
-float v_orbit(float r_iso) {
-    float r_phys = r_iso * metricAB(max(r_iso,1e-6)).B;
+float v_orbit(float r_phys) {
     return clamp(sqrt(max(0.0, RS / (2.0 * max(r_phys, R_DISK_IN)))), 0.0, 0.75);
 }
 float grav_redshift(float r_iso) {
@@ -130,8 +229,45 @@ float doppler(vec3 v, vec3 n) {
     return 1.0 / (gamma * max(0.05, 1.0 - dot(v, n)));
 }
 
+// ==================== Disk emission ====================
+// One disk sample is diskModulation() * diskWeight(): the weight holds the
+// time-independent falloff and redshift, the modulation everything that
+// moves. Keep diskModulation in sync with lens_compose.frag.
+float diskWeight(float r_iso, float r_phys) {
+    float t = clamp(R_DISK_IN / r_phys, 0.0, 1.0);
+    return 4.0 * (t*t) * grav_redshift(r_iso) * 0.05;
+}
+
+// nxz: xz of the unit photon direction (the orbital velocity has no y)
+vec3 diskModulation(float r_phys, float ang, vec2 nxz, float time) {
+    float vK    = v_orbit(r_phys);
+    float omega = vK / max(r_phys, 1e-4);
+    float phase = ang + omega * time * SPIN_SCALE;
+
+    vec2 vphi = vec2(-sin(phase), cos(phase)) * vK;
+
+    float sector = floor(mod(phase,6.28318)*18.0);
+    float ring   = floor(clamp((r_phys-R_DISK_IN)/(R_DISK_OUT-R_DISK_IN),0.0,0.999)*20.0);
+    float twRnd  = hash31(vec3(sector,ring,7.0));
+    float tw     = 0.9 + 0.2 * twRnd;
+
+    float hs = 0.0;
+    for(int j=0;j<HOTSPOTS;++j){
+        float phi_j = 6.28318*float(j)/float(max(HOTSPOTS,1));
+        float dphi  = acos(clamp(cos(phase-phi_j),-1.0,1.0));
+        float ga = exp(- (dphi*dphi)/(2.0*HOTSIGMA_A*HOTSIGMA_A));
+        float gr = exp(- ((r_phys-HOT_R0)*(r_phys-HOT_R0)) / (2.0*HOTSIGMA_R*HOTSIGMA_R));
+        hs += ga*gr;
+    }
+    hs = clamp(hs,0.0,2.0);
+    float flick = 1.0 + FLICKER_AMT*sin(time*(1.7+0.3*twRnd)+4.0*twRnd);
+
+    float D = pow(doppler(vec3(vphi.x, 0.0, vphi.y), vec3(nxz.x, 0.0, nxz.y)), 1.3);
+    return vec3(2.0,1.0,0.6) * (tw*flick) * (1.0 + 0.6*hs) * D;
+}
+
 // ==================== Ray tracer ====================
-struct Sample { bool absorbed; vec3 col; };
+struct Sample { bool absorbed; vec3 col; int steps; uint reason; };
 
 Sample traceGeodesic(vec3 ro_world, vec3 rd_world)
 {
@@ -142,49 +278,42 @@ Sample traceGeodesic(vec3 ro_world, vec3 rd_world)
 
     float lambda = 0.0;
     vec3 accum = vec3(0.0);
+    int  steps = 0;
+    uint reason = REASON_EXHAUSTED;
+#ifdef WARP_MAP
+    // a ray that never enters the lensing region keeps its straight line
+    gExitPos = ro_world; gExitDir = normalize(rd_world);
+    bool inside = rho0 < R_LENS;
+    int  crossing = -1;
+    bool inDisk = false;
+#endif
 
     for (int i=0; i<N_STEPS; ++i) {
         float rho = length(x);
-        if (rho < R_PH_ISO && dot(x,p)<0.0) { Sample s; s.absorbed=true; s.col=vec3(0.0); return s; }
-        if (rho <= HZN_ISO) { Sample s; s.absorbed=true; s.col=vec3(0.0); return s; }
+        if (rho < R_PH_ISO && dot(x,p)<0.0) { Sample s; s.absorbed=true; s.col=vec3(0.0); s.steps=steps; s.reason=REASON_PHOTON_SPHERE; return s; }
+        if (rho <= HZN_ISO) { Sample s; s.absorbed=true; s.col=vec3(0.0); s.steps=steps; s.reason=REASON_HORIZON; return s; }
 
         float h = H_BASE * mix(0.15,1.0,smoothstep(RS*0.6,6.0*RS,rho));
         float r_iso  = max(rho, 1e-6);
         float r_phys = r_iso * metricAB(r_iso).B;
 
         // --- Disk emission (animated) ---
-        if (abs(x.y) < 0.12 && r_phys > R_DISK_IN && r_phys < R_DISK_OUT) {
-            float ang   = atan(x.z, x.x);
-            float vK    = v_orbit(r_iso);
-            float omega = vK / max(r_phys, 1e-4);
-            float phase = ang + omega * uTime * SPIN_SCALE;
-
-            vec3 vphi = normalize(vec3(-sin(phase),0.0,cos(phase))) * vK;
-
-            float t     = clamp(R_DISK_IN / r_phys,0.0,1.0);
-            float emi   = 4.0*(t*t);
-
-            float sector = floor(mod(phase,6.28318)*18.0);
-            float ring   = floor(clamp((r_phys-R_DISK_IN)/(R_DISK_OUT-R_DISK_IN),0.0,0.999)*20.0);
-            float twRnd  = hash31(vec3(sector,ring,7.0));
-            float tw     = 0.9 + 0.2 * twRnd;
-
-            float hs = 0.0;
-            for(int j=0;j<HOTSPOTS;++j){
-                float phi_j = 6.28318*float(j)/float(max(HOTSPOTS,1));
-                float dphi  = acos(clamp(cos(phase-phi_j),-1.0,1.0));
-                float ga = exp(- (dphi*dphi)/(2.0*HOTSIGMA_A*HOTSIGMA_A));
-                float gr = exp(- ((r_phys-HOT_R0)*(r_phys-HOT_R0)) / (2.0*HOTSIGMA_R*HOTSIGMA_R));
-                hs += ga*gr;
-            }
-            hs = clamp(hs,0.0,2.0);
-            float flick = 1.0 + FLICKER_AMT*sin(uTime*(1.7+0.3*twRnd)+4.0*twRnd);
-            vec3 disk = vec3(2.0,1.0,0.6) * emi * (tw*flick) * (1.0 + 0.6*hs);
-
-            float g = grav_redshift(r_iso);
-            float D = pow(doppler(vphi, normalize(p)),1.3);
-            accum += disk * g * D * 0.05;
+        bool inSlab = abs(x.y) < 0.12 && r_phys > R_DISK_IN && r_phys < R_DISK_OUT;
+        if (inSlab) {
+            float w = diskWeight(r_iso, r_phys);
+            vec3  n = normalize(p);
+#ifdef WARP_MAP
+            if (!inDisk) ++crossing;
+            if (crossing < WARP_CROSSINGS) {
+                gCross[crossing]    += w * vec4(x.x, x.z, r_phys, 1.0);
+                gCrossDir[crossing] += w * n;
+            } else   // higher-order images, a few pixels at the shadow's rim: baked
+#endif
+            accum += diskModulation(r_phys, atan(x.z, x.x), n.xz, uTime) * w;
         }
+#ifdef WARP_MAP
+        inDisk = inSlab;
+#endif
 
         // --- Coronal gas (soft halo) ---
         {
@@ -201,13 +330,23 @@ Sample traceGeodesic(vec3 ro_world, vec3 rd_world)
         }
 
         rk4(x,p,h);
+        ++steps;
+#ifdef WARP_MAP
+        // outward beyond the photon sphere: this crossing is final
+        if (length(x) < R_LENS) inside = true;
+        else if (inside && dot(x,p) > 0.0) { inside = false; gExitPos = x; gExitDir = normalize(p); }
+#endif
         lambda+=h;
-        if(lambda>LAMBDA_MAX)break;
-        if(length(x-ro_world)>200.0)break;
+        if(lambda>LAMBDA_MAX){reason=REASON_LAMBDA_MAX;break;}
+        if(length(x-ro_world)>200.0){reason=REASON_ESCAPED;break;}
     }
 
+#ifdef WARP_MAP
+    if (inside) { gExitPos = x; gExitDir = normalize(p); }
+    gEmit = accum;
+#endif
     vec3 lensedSky = starBackground(normalize(p));
-    Sample s; s.absorbed=false; s.col=accum+lensedSky; return s;
+    Sample s; s.absorbed=false; s.col=accum+lensedSky; s.steps=steps; s.reason=reason; return s;
 }
 
 // ==================== Main ====================
@@ -215,6 +354,22 @@ void main(){
     vec3 ro=uCameraPos;
     vec3 rd=rayDirection(vNDC);
     Sample s=traceGeodesic(ro,rd);
+#ifdef WARP_MAP
+    FragColor=vec4(gExitPos, s.absorbed ? 0.0 : 1.0);
+    WarpDir=vec4(gExitDir, gCross[0].w);
+    WarpEmit=vec4(gEmit, gCross[1].w);
+    for (int k=0; k<WARP_CROSSINGS; ++k) {
+        // weighted means: radius, azimuth of the mean position, mean direction
+        vec4 d = vec4(0.0);
+        float w = gCross[k].w;
+        if (w > 0.0) d = vec4(gCross[k].z / w, atan(gCross[k].y, gCross[k].x), normalize(gCrossDir[k]).xz);
+        if (k == 0) WarpDisk0 = d; else WarpDisk1 = d;
+    }
+    return;
+#endif
+#ifdef RAY_STATS
+    writeStats(s.steps, s.reason);
+#endif
     if(s.absorbed){FragColor=vec4(0.0);return;}
     FragColor=vec4(s.col,1.0);
 }
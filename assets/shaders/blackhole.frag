@@ -2,10 +2,13 @@
 out vec4 FragColor;
 in vec2 vNDC;
 
-uniform mat4 uInvVP;
-uniform vec2 uResolution;
-uniform float uTime;
-uniform vec3 uCameraPos;
+// per-frame data, see FrameData in frame_ring.h
+layout(std140) uniform FrameData {
+    mat4  uInvVP;
+    vec3  uCameraPos;
+    float uTime;
+    vec2  uResolution;
+};
 
 // ==================== Physical params (scene units, c=1) ====================
 const float RS         = 0.8;              // Schwarzschild radius
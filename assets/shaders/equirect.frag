@@ -0,0 +1,36 @@
+#version 330 core
+out vec4 FragColor;
+in vec2 vNDC;
+
+// six cube faces traced by MultiView, layer order +X -X +Y -Y +Z -Z
+uniform sampler2DArray uFaces;
+
+const float PI = 3.14159265;
+
+// face forward / up, keep in sync with CUBE_FACES in multiview.cpp
+const vec3 FACE_F[6] = vec3[6](vec3( 1, 0, 0), vec3(-1, 0, 0), vec3(0, 1, 0),
+                               vec3( 0,-1, 0), vec3( 0, 0, 1), vec3(0, 0,-1));
+const vec3 FACE_U[6] = vec3[6](vec3( 0, 1, 0), vec3( 0, 1, 0), vec3(0, 0, 1),
+                               vec3( 0, 0,-1), vec3( 0, 1, 0), vec3(0, 1, 0));
+
+void main() {
+    // longitude 0 looks down -Z, same as the default camera
+    vec2  uv  = vNDC * 0.5 + 0.5;
+    float lon = (uv.x - 0.5) * 2.0 * PI;
+    float lat = (uv.y - 0.5) * PI;
+    vec3  dir = vec3(sin(lon) * cos(lat), sin(lat), -cos(lon) * cos(lat));
+
+    vec3 a = abs(dir);
+    int face;
+    if (a.x >= a.y && a.x >= a.z) face = dir.x > 0.0 ? 0 : 1;
+    else if (a.y >= a.z)          face = dir.y > 0.0 ? 2 : 3;
+    else                          face = dir.z > 0.0 ? 4 : 5;
+
+    vec3  f = FACE_F[face];
+    vec3  u = FACE_U[face];
+    vec3  r = cross(f, u);
+    float d = dot(dir, f);
+    vec2  st = vec2(dot(dir, r), dot(dir, u)) / d * 0.5 + 0.5;
+
+    FragColor = vec4(texture(uFaces, vec3(st, float(face))).rgb, 1.0);
+}
@@ -0,0 +1,177 @@
+#version 330 core
+in vec2 vNDC;
+out vec4 FragColor;
+
+// per-frame data, see FrameData in frame_ring.h
+layout(std140) uniform FrameData {
+    mat4  uInvVP;
+    vec3  uCameraPos;
+    float uTime;
+    vec2  uResolution;
+};
+
+// warp map traced by animated_blackhole.frag (WARP_MAP)
+uniform sampler2D uWarpPos;     // exit position, transmittance
+uniform sampler2D uWarpDir;     // exit direction, disk weight of crossing 0
+uniform sampler2D uWarpEmit;    // static emission along the path, disk weight of crossing 1
+uniform sampler2D uWarpDisk0;   // disk crossing 0: r_phys, azimuth, photon dir xz
+uniform sampler2D uWarpDisk1;   // disk crossing 1
+// unlensed scene around the hole
+uniform samplerCube uEnvColor;  // rgb, coverage
+uniform samplerCube uEnvDist;   // distance from the hole, 0 where empty
+
+const float RS     = 0.8;
+const float R_LENS = 12.0 * RS;   // keep in sync with animated_blackhole.frag
+const float R_FAR  = 1e4;         // stands in for empty texels
+const int   PARALLAX_ITERS = 2;
+
+// disk animation, keep in sync with animated_blackhole.frag
+const float R_DISK_IN    = 0.9 * RS;
+const float R_DISK_OUT   = 12.0 * RS;
+const float SPIN_SCALE   = 1.0;
+const float FLICKER_AMT  = 0.25;
+const int   HOTSPOTS     = 3;
+const float HOTSIGMA_A   = 0.20;
+const float HOTSIGMA_R   = 0.7*RS;
+const float HOT_R0       = 2.2*RS;
+
+// same stars as the tracer, so escaped rays without an object match it
+float hash31(vec3 p) {
+    p = fract(p * 0.3183099 + 0.1);
+    p += dot(p, p.yzx + 19.19);
+    return fract(p.x*p.y*p.z);
+}
+
+vec3 starBackground(vec3 rd) {
+    vec3 p = normalize(rd);
+    float d = 200.0;
+    float s = 0.0;
+    for (int i=0; i<3; ++i) {
+        vec3 cell = floor(p*d + float(i)*37.0);
+        float h = hash31(cell);
+        s += smoothstep(0.995, 1.0, h) * (1.0 + 3.0*float(i));
+        d *= 1.7;
+    }
+    vec3 base = vec3(0.04, 0.05, 0.08);
+    return base + s * vec3(0.9, 0.9, 1.0);
+}
+
+// ==================== Disk, as in the tracer ====================
+float v_orbit(float r_phys) {
+    return clamp(sqrt(max(0.0, RS / (2.0 * max(r_phys, R_DISK_IN)))), 0.0, 0.75);
+}
+float doppler(vec3 v, vec3 n) {
+    float v2 = dot(v,v);
+    float gamma = 1.0 / sqrt(max(1e-6, 1.0 - v2));
+    return 1.0 / (gamma * max(0.05, 1.0 - dot(v, n)));
+}
+
+vec3 diskModulation(float r_phys, float ang, vec2 nxz, float time) {
+    float vK    = v_orbit(r_phys);
+    float omega = vK / max(r_phys, 1e-4);
+    float phase = ang + omega * time * SPIN_SCALE;
+
+    vec2 vphi = vec2(-sin(phase), cos(phase)) * vK;
+
+    float sector = floor(mod(phase,6.28318)*18.0);
+    float ring   = floor(clamp((r_phys-R_DISK_IN)/(R_DISK_OUT-R_DISK_IN),0.0,0.999)*20.0);
+    float twRnd  = hash31(vec3(sector,ring,7.0));
+    float tw     = 0.9 + 0.2 * twRnd;
+
+    float hs = 0.0;
+    for(int j=0;j<HOTSPOTS;++j){
+        float phi_j = 6.28318*float(j)/float(max(HOTSPOTS,1));
+        float dphi  = acos(clamp(cos(phase-phi_j),-1.0,1.0));
+        float ga = exp(- (dphi*dphi)/(2.0*HOTSIGMA_A*HOTSIGMA_A));
+        float gr = exp(- ((r_phys-HOT_R0)*(r_phys-HOT_R0)) / (2.0*HOTSIGMA_R*HOTSIGMA_R));
+        hs += ga*gr;
+    }
+    hs = clamp(hs,0.0,2.0);
+    float flick = 1.0 + FLICKER_AMT*sin(time*(1.7+0.3*twRnd)+4.0*twRnd);
+
+    float D = pow(doppler(vec3(vphi.x, 0.0, vphi.y), vec3(nxz.x, 0.0, nxz.y)), 1.3);
+    return vec3(2.0,1.0,0.6) * (tw*flick) * (1.0 + 0.6*hs) * D;
+}
+
+vec3 rayDirection(vec2 ndc)
+{
+    vec4 pNear = vec4(ndc, -1.0, 1.0);
+    vec4 pFar  = vec4(ndc,  1.0, 1.0);
+    vec4 wNear = uInvVP * pNear;  wNear /= wNear.w;
+    vec4 wFar  = uInvVP * pFar;   wFar  /= wFar.w;
+    return normalize(vec3(wFar - wNear));
+}
+
+// t >= 0 where o + t d first meets |p| = r: the near root from outside the
+// sphere, the way out (far root) from inside. hit = false if the ray misses
+// the sphere or it lies behind; t is then the closest approach.
+float reach(vec3 o, vec3 d, float r, out bool hit) {
+    float b = dot(o, d);
+    float c = dot(o, o) - r*r;
+    float disc = b*b - c;
+    float s = sqrt(max(disc, 0.0));
+    if (c <= 0.0) { hit = true; return -b + s; }
+    hit = disc > 0.0 && b < 0.0;
+    return hit ? -b - s : max(-b, 0.0);
+}
+
+// Straight ray o + t d against the distance cubemap: guess the hit from
+// the stored distance in the current direction, re-aim at the guess,
+// repeat (distance impostor iteration). Returns the env texel at the
+// final direction; a = 0 means nothing was hit.
+vec4 envLookup(vec3 o, vec3 d, float tMax) {
+    vec3 dir = d;
+    bool hit;
+    for (int i = 0; i < PARALLAX_ITERS; ++i) {
+        float D = texture(uEnvDist, dir).r;
+        float t = reach(o, d, D > 0.0 ? D : R_FAR, hit);
+        dir = normalize(o + d * min(t, R_FAR));
+    }
+    vec4 env = texture(uEnvColor, dir);
+    float D = texture(uEnvDist, dir).r;
+    // the first crossing of the object's distance sphere must lie within tMax
+    float t = reach(o, d, max(D, 0.0), hit);
+    if (D <= 0.0 || !hit || t > tMax) env = vec4(0.0);
+    return env;
+}
+
+void main() {
+    ivec2 px = ivec2(gl_FragCoord.xy);
+    vec4 pos  = texelFetch(uWarpPos, px, 0);
+    vec4 dirW = texelFetch(uWarpDir, px, 0);
+    vec4 emW  = texelFetch(uWarpEmit, px, 0);
+    vec3 dir  = dirW.xyz;
+
+    // static part baked, the disk evaluated for this frame's time
+    vec3 emit = emW.rgb;
+    if (dirW.w > 0.0) {
+        vec4 c = texelFetch(uWarpDisk0, px, 0);
+        emit += dirW.w * diskModulation(c.x, c.y, c.zw, uTime);
+    }
+    if (emW.w > 0.0) {
+        vec4 c = texelFetch(uWarpDisk1, px, 0);
+        emit += emW.w * diskModulation(c.x, c.y, c.zw, uTime);
+    }
+
+    vec3 col = vec3(0.0);   // absorbed
+    if (pos.w > 0.0) {
+        vec4 env = envLookup(pos.xyz, dir, 1e30);
+        vec3 bg  = env.rgb + (1.0 - env.a) * starBackground(dir);
+        col = emit + pos.w * bg;
+    }
+
+    // camera outside the lensing region: objects between it and the region
+    // are seen along the straight primary ray, in front of everything else
+    float rc = length(uCameraPos);
+    if (rc > R_LENS) {
+        vec3 rd = rayDirection(vNDC);
+        float b = dot(uCameraPos, rd);
+        float disc = b*b - (rc*rc - R_LENS*R_LENS);
+        if (disc > 0.0 && b < 0.0) {
+            vec4 front = envLookup(uCameraPos, rd, -b - sqrt(disc));
+            col = front.rgb + (1.0 - front.a) * col;
+        }
+    }
+
+    FragColor = vec4(col, 1.0);
+}
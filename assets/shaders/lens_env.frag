@@ -0,0 +1,11 @@
+#version 330 core
+in vec3 vCol;
+in vec3 vWorld;
+
+layout(location = 0) out vec4 EnvColor;   // rgb + coverage
+layout(location = 1) out float EnvDist;   // distance from the hole
+
+void main() {
+    EnvColor = vec4(vCol, 1.0);
+    EnvDist = length(vWorld);
+}
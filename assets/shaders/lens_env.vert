@@ -0,0 +1,16 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aCol;
+
+uniform mat4 uModel;
+uniform mat4 uVP;      // one cube face, centred on the hole
+
+out vec3 vCol;
+out vec3 vWorld;
+
+void main() {
+    vec4 world = uModel * vec4(aPos, 1.0);
+    vCol = aCol;
+    vWorld = world.xyz;
+    gl_Position = uVP * world;
+}
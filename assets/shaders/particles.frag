@@ -0,0 +1,14 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2  vCorner;
+in float vGain;
+in float vHeat;
+
+void main() {
+    float r2 = dot(vCorner, vCorner);
+    if (r2 > 1.0) discard;
+    float a = exp(-4.0 * r2) * vGain;
+    vec3 col = mix(vec3(1.0, 0.45, 0.2), vec3(1.0, 0.9, 0.75), vHeat);
+    FragColor = vec4(col * a * 0.35, 1.0);   // additive
+}
@@ -0,0 +1,88 @@
+#version 330 core
+// One instanced quad per particle; positions come straight from the
+// ParticleSystem SoA arrays (one float attribute per axis), in areal
+// Schwarzschild coordinates, and are moved to the tracer's isotropic ones here.
+layout(location = 0) in vec2  aCorner;   // [-1,1]^2
+layout(location = 1) in float aX;
+layout(location = 2) in float aY;
+layout(location = 3) in float aZ;
+
+// per-frame data, see FrameData in frame_ring.h
+layout(std140) uniform FrameData {
+    mat4  uInvVP;
+    vec3  uCameraPos;
+    float uTime;
+    vec2  uResolution;
+};
+
+uniform mat4  uVP;
+uniform float uSize;       // sprite radius in pixels
+
+out vec2  vCorner;
+out float vGain;
+out float vHeat;
+
+const float RS     = 0.8;
+const float B_CRIT = 2.598076 * RS;   // critical impact parameter, 3*sqrt(3)/2 RS
+
+// areal r -> isotropic rho along the same direction, the inverse of
+// r = rho (1 + RS/(4 rho))^2 the tracer uses for the disk
+vec3 isotropicPosition(vec3 P) {
+    float r   = length(P);
+    float rho = 0.5 * (r - 0.5 * RS + sqrt(max(r * r - r * RS, 0.0)));
+    return P * (rho / max(r, 1e-6));
+}
+
+// ==================== Point-lens mapping ====================
+/*
+   Thin lens with the hole at the origin, observer at uCameraPos.
+   With Dl = |camera|, Ds = distance to the source along the optic
+   axis and beta its angle from the axis, the primary image sits at
+       theta = (beta + sqrt(beta^2 + 4 thetaE^2)) / 2,
+       thetaE^2 = 2 RS (Ds - Dl) / (Dl Ds)
+   with magnification mu = (u^2 + 2) / (u sqrt(u^2 + 4)), u = beta/thetaE.
+   Sources in front of the hole are left alone; images inside the
+   shadow (theta < B_CRIT / Dl) are dropped. Distances are isotropic;
+   they differ from areal ones by O(RS), below the thin-lens accuracy.
+*/
+vec3 lensedPosition(vec3 P, out float gain) {
+    gain = 1.0;
+    vec3  toL  = -uCameraPos;
+    float Dl   = length(toL);
+    vec3  axis = toL / max(Dl, 1e-4);
+
+    vec3  toS  = P - uCameraPos;
+    float dist = length(toS);
+    float Ds   = dot(toS, axis);
+    if (Ds <= Dl || Dl < 1e-3) return P;
+
+    vec3  perp  = toS - axis * Ds;
+    float pl    = length(perp);
+    float beta  = atan(pl, Ds);
+    float thE2  = 2.0 * RS * (Ds - Dl) / (Dl * Ds);
+    float theta = 0.5 * (beta + sqrt(beta * beta + 4.0 * thE2));
+
+    if (theta * Dl < B_CRIT) { gain = 0.0; return P; }
+
+    float u = beta / sqrt(thE2);
+    gain = min((u * u + 2.0) / max(u * sqrt(u * u + 4.0), 1e-4), 8.0);
+
+    vec3 side = (pl > 1e-6) ? perp / pl : vec3(0.0, 1.0, 0.0);
+    vec3 dir  = axis * cos(theta) + side * sin(theta);
+    return uCameraPos + dir * dist;
+}
+
+void main() {
+    vec3 P = isotropicPosition(vec3(aX, aY, aZ));
+    float gain;
+    vec3 A = lensedPosition(P, gain);
+
+    vec4 clip = uVP * vec4(A, 1.0);
+    clip.xy += aCorner * (uSize * 2.0 / uResolution) * clip.w;
+    if (gain <= 0.0) clip = vec4(2.0, 2.0, 2.0, 1.0);   // outside the clip volume
+
+    gl_Position = clip;
+    vCorner = aCorner;
+    vGain   = gain;
+    vHeat   = clamp(3.0 * RS / length(vec3(aX, aY, aZ)), 0.0, 1.0);  // hotter further in (areal r)
+}
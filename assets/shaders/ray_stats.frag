@@ -0,0 +1,28 @@
+#version 330 core
+out vec4 FragColor;
+in vec2 vNDC;
+
+// Output of the RAY_STATS build of the tracer
+uniform sampler2D  uColor;   // traced image
+uniform usampler2D uStats;   // uvec4(iterations, reason, rhs evals, 0)
+uniform float      uMaxSteps;
+
+// blue -> cyan -> green -> yellow -> red
+vec3 heat(float t) {
+    t = clamp(t, 0.0, 1.0);
+    vec3 c = vec3(0.0);
+    c.r = smoothstep(0.5, 0.75, t);
+    c.g = smoothstep(0.0, 0.25, t) - smoothstep(0.75, 1.0, t);
+    c.b = 1.0 - smoothstep(0.25, 0.5, t);
+    return c;
+}
+
+void main() {
+    ivec2 px   = ivec2(gl_FragCoord.xy);
+    uvec4 s    = texelFetch(uStats, px, 0);
+    vec3  base = texelFetch(uColor, px, 0).rgb;
+
+    // sqrt spreads the cheap end of the range, most pixels escape early
+    float t = sqrt(float(s.x) / uMaxSteps);
+    FragColor = vec4(mix(base, heat(t), 0.7), 1.0);
+}
@@ -1,19 +1,65 @@
 #version 330 core
-out vec4 FragColor;
+layout(location = 0) out vec4 FragColor;
 in vec2 vNDC;
 
-uniform mat4 uInvVP;
-uniform vec2 uResolution;
-uniform float uTime;
-uniform vec3 uCameraPos;
+// per-frame data, see FrameData in frame_ring.h
+layout(std140) uniform FrameData {
+    mat4  uInvVP;
+    vec3  uCameraPos;
+    float uTime;
+    vec2  uResolution;
+};
+
+#ifdef SDF_STATS
+// attachment 1: uvec2(march steps, primitive evaluations), see SdfScene::benchmark
+layout(location = 1) out uvec2 StatsOut;
+#endif
+uint gEvals = 0u;
+
+// =========================================================
+// Primitive list + uniform grid, see SdfScene in sdf_scene.h
+// =========================================================
+uniform samplerBuffer  uPrims;      // 3 texels / primitive: (center, type) (size, round) (albedo, 0)
+uniform isamplerBuffer uCells;      // per cell: (first index, count) into uCellPrims
+uniform isamplerBuffer uCellPrims;  // primitive indices, cell by cell
+uniform int   uPrimCount;
+uniform vec3  uGridMin;
+uniform float uCellSize;
+uniform ivec3 uGridDim;
+uniform float uMargin;    // every primitive within uMargin of a cell is in its list
+uniform int   uUseGrid;   // 0: evaluate every primitive per step (reference)
+uniform float uOmega;     // over-relaxation, 1 = plain sphere tracing
+
+const int   PRIM_SPHERE    = 0;
+const int   PRIM_BOX       = 1;
+const int   PRIM_ROUND_BOX = 2;
+const float T_MAX          = 100.0;
+const int   MAX_STEPS      = 256;
+const float BIG            = 1e9;
 
 // =========================================================
 // Signed-distance scene
 // =========================================================
 float sdSphere(vec3 p, float r) { return length(p) - r; }
 float sdPlaneY(vec3 p, float h) { return p.y - h; }
+float sdBox(vec3 p, vec3 b) {
+    vec3 q = abs(p) - b;
+    return length(max(q, 0.0)) + min(max(q.x, max(q.y, q.z)), 0.0);
+}
+
+float primSDF(int i, vec3 p)
+{
+    ++gEvals;
+    vec4 a = texelFetch(uPrims, 3 * i);
+    vec4 b = texelFetch(uPrims, 3 * i + 1);
+    vec3 q = p - a.xyz;
+    int type = int(a.w);
+    if (type == PRIM_SPHERE) return sdSphere(q, b.x);
+    return sdBox(q, b.xyz) - b.w;   // box / round box
+}
 
-float mapSDF(vec3 p, out int matID)
+// the original hero sphere and floor; cheap, evaluated everywhere
+float globalSDF(vec3 p, out int matID)
 {
     vec3 c = vec3(0.0, 0.6 + 0.2 * sin(uTime), 0.0);
     float d0 = sdSphere(p - c, 0.75);
@@ -22,19 +68,96 @@ float mapSDF(vec3 p, out int matID)
     matID = 2; return d1;
 }
 
+// 1/d without infinities on axis-aligned rays
+vec3 safeInv(vec3 d) {
+    vec3 s = vec3(greaterThanEqual(d, vec3(0.0))) * 2.0 - 1.0;
+    return 1.0 / (s * max(abs(d), vec3(1e-8)));
+}
+
+// Grid primitives near p. Returns a distance bound (a sphere around p
+// free of grid primitives); `free` is how far the ray can advance from
+// p without meeting one, which beats the bound in empty cells and
+// outside the grid.
+float gridSDF(vec3 p, vec3 rd, out float free, out int prim)
+{
+    prim = -1;
+    vec3 invRd = safeInv(rd);
+    vec3 gmax = uGridMin + vec3(uGridDim) * uCellSize;
+    vec3 c = floor((p - uGridMin) / uCellSize);
+
+    if (any(lessThan(c, vec3(0.0))) || any(greaterThanEqual(c, vec3(uGridDim)))) {
+        // outside the grid: nothing until the ray enters the box
+        vec3 t0 = (uGridMin - p) * invRd, t1 = (gmax - p) * invRd;
+        vec3 tn = min(t0, t1), tf = max(t0, t1);
+        float tNear = max(max(tn.x, tn.y), tn.z), tFar = min(min(tf.x, tf.y), tf.z);
+        vec3 e = 0.5 * (gmax - uGridMin);
+        float d = max(sdBox(p - (uGridMin + e), e), 0.0);
+        free = (tFar < max(tNear, 0.0)) ? BIG : max(tNear, 0.0) + 1e-3 * uCellSize;
+        return (free == BIG) ? BIG : d;
+    }
+
+    ivec3 ci = ivec3(c);
+    ivec2 list = texelFetch(uCells, (ci.z * uGridDim.y + ci.y) * uGridDim.x + ci.x).xy;
+
+    float d = uMargin;
+    for (int k = 0; k < list.y; ++k) {
+        int i = texelFetch(uCellPrims, list.x + k).r;
+        float di = primSDF(i, p);
+        if (di < d) { d = di; prim = i; }
+    }
+
+    free = 0.0;
+    if (list.y == 0) {
+        // empty cell: skip to where the ray leaves it
+        vec3 cmin = uGridMin + c * uCellSize;
+        vec3 tx = (mix(cmin, cmin + uCellSize, step(0.0, rd)) - p) * invRd;
+        free = min(min(tx.x, tx.y), tx.z) + 1e-3 * uCellSize;
+    }
+    return d;
+}
+
+float mapSDF(vec3 p, vec3 rd, out float free, out int matID, out int prim)
+{
+    float dg = globalSDF(p, matID);
+    float d;
+    prim = -1;
+    if (uUseGrid != 0) {
+        float fg;
+        d = gridSDF(p, rd, fg, prim);
+        free = min(max(d, fg), dg);
+    } else {
+        d = BIG;
+        for (int i = 0; i < uPrimCount; ++i) {
+            float di = primSDF(i, p);
+            if (di < d) { d = di; prim = i; }
+        }
+        free = min(d, dg);
+    }
+    if (dg <= d) { prim = -1; return dg; }
+    matID = 3;
+    return d;
+}
+
+float mapSDF(vec3 p)
+{
+    float free; int m, prim;
+    return mapSDF(p, vec3(0.0, 0.0, 1.0), free, m, prim);
+}
+
 // =========================================================
 // Helpers
 // =========================================================
-vec3 estimateNormal(vec3 p)
+// Cone-traced normal: the tetrahedron taps are spread over the pixel's
+// footprint at the hit (eps = cone radius), which filters detail smaller
+// than a pixel instead of aliasing it.
+vec3 estimateNormal(vec3 p, float eps)
 {
-    const float e = 1e-3;
-    int m;
     vec2 k = vec2(1.0, -1.0);
     return normalize(
-          k.xyy * mapSDF(p + k.xyy * e, m)
-        + k.yyx * mapSDF(p + k.yyx * e, m)
-        + k.yxy * mapSDF(p + k.yxy * e, m)
-        + k.xxx * mapSDF(p + k.xxx * e, m));
+          k.xyy * mapSDF(p + k.xyy * eps)
+        + k.yyx * mapSDF(p + k.yyx * eps)
+        + k.yxy * mapSDF(p + k.yxy * eps)
+        + k.xxx * mapSDF(p + k.xxx * eps));
 }
 
 // reconstruct a ray direction from NDC using inverse VP
@@ -50,22 +173,54 @@ vec3 rayDirection(vec2 ndc)
 // =========================================================
 // Ray march
 // =========================================================
-struct Hit { bool ok; float t; vec3 p; vec3 n; int matID; };
+struct Hit { bool ok; float t; vec3 p; vec3 n; int matID; int prim; int steps; };
 
-Hit raymarch(vec3 ro, vec3 rd)
+// Enhanced sphere tracing (Keinert et al. 2014): steps are stretched by
+// uOmega while consecutive unbounding spheres still overlap, and undone
+// otherwise. The ray stops once the bound falls inside the pixel cone;
+// failing that, the closest approach in cone terms is kept.
+Hit raymarch(vec3 ro, vec3 rd, float pixelRadius)
 {
-    float t = 0.0;
-    int matID = 0;
-    for (int i = 0; i < 128; ++i) {
-        vec3 p = ro + rd * t;
-        float d = mapSDF(p, matID);
-        if (d < 1e-3) {
-            Hit h; h.ok = true; h.t = t; h.p = p; h.n = estimateNormal(p); h.matID = matID; return h;
+    float omega = uOmega;
+    float t = 1e-3;
+    float candT = t, candErr = BIG;
+    int   candMat = 0, candPrim = -1;
+    float prevRadius = 0.0, stepLength = 0.0;
+    int   steps = 0;
+
+    for (int i = 0; i < MAX_STEPS; ++i) {
+        ++steps;
+        float free; int matID, prim;
+        float signedRadius = mapSDF(ro + rd * t, rd, free, matID, prim);
+        float radius = abs(signedRadius);
+
+        bool sorFail = omega > 1.0 && (radius + prevRadius) < stepLength;
+        if (sorFail) {
+            stepLength -= omega * stepLength;
+            omega = 1.0;
+        } else if (signedRadius > 0.0 && free > signedRadius * omega) {
+            // empty cell / outside the grid: the skipped span is known to be
+            // empty, so the next overlap test must pass
+            stepLength = free;
+            radius = BIG;
+        } else {
+            stepLength = signedRadius * omega;
         }
-        t += d;
-        if (t > 100.0) break;
+        prevRadius = radius;
+
+        float err = abs(signedRadius) / t;
+        if (!sorFail && err < candErr) { candT = t; candErr = err; candMat = matID; candPrim = prim; }
+        if ((!sorFail && err < pixelRadius) || t > T_MAX) break;
+        t += stepLength;
     }
-    Hit miss; miss.ok = false; return miss;
+
+    Hit h;
+    h.steps = steps;
+    h.ok = candErr <= pixelRadius && candT < T_MAX;
+    if (!h.ok) return h;
+    h.t = candT; h.p = ro + rd * candT; h.matID = candMat; h.prim = candPrim;
+    h.n = estimateNormal(h.p, max(pixelRadius * candT, 1e-4));
+    return h;
 }
 
 // =========================================================
@@ -75,9 +230,9 @@ vec3 shade(Hit h, vec3 ro)
 {
     vec3 L = normalize(vec3(0.6, 0.9, 0.3));
     float ndl = max(dot(h.n, L), 0.0);
-    vec3 albedo = (h.matID == 1)
-        ? vec3(0.9, 0.5, 0.3)
-        : vec3(0.25, 0.35, 0.45);
+    vec3 albedo = (h.matID == 1) ? vec3(0.9, 0.5, 0.3)
+                : (h.matID == 3) ? texelFetch(uPrims, 3 * h.prim + 2).rgb
+                                 : vec3(0.25, 0.35, 0.45);
     vec3 diff = albedo * ndl + 0.05 * albedo;
     float fog = clamp(h.t / 40.0, 0.0, 1.0);
     return mix(diff, vec3(0.02, 0.03, 0.05), fog);
@@ -90,8 +245,13 @@ void main()
 {
     vec3 ro = uCameraPos;
     vec3 rd = rayDirection(vNDC);
+    // angular size of a pixel: the cone every ray stands for
+    float pixelRadius = length(rayDirection(vNDC + vec2(0.0, 2.0 / uResolution.y)) - rd);
 
-    Hit h = raymarch(ro, rd);
+    Hit h = raymarch(ro, rd, pixelRadius);
+#ifdef SDF_STATS
+    StatsOut = uvec2(uint(h.steps), gEvals);
+#endif
     if (!h.ok) {
         float t = 0.5 * (rd.y + 1.0);
         vec3 sky = mix(vec3(0.06, 0.07, 0.10),
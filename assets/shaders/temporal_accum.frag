@@ -0,0 +1,36 @@
+#version 330 core
+in vec2 vNDC;
+out vec4 FragColor;   // rgb running mean, a sample count
+
+uniform sampler2D uCurrent;   // this frame's jittered sample
+uniform sampler2D uHistory;   // previous accumulation
+uniform mat4  uCurInvVP;      // unjittered, this frame
+uniform mat4  uPrevVP;        // unjittered, the history's camera
+uniform int   uMode;          // 0 restart, 1 same view, 2 reproject
+uniform float uMaxCount;      // history weight cap
+
+void main()
+{
+    ivec2 px = ivec2(gl_FragCoord.xy);
+    vec3 cur = texelFetch(uCurrent, px, 0).rgb;
+
+    vec4 hist = vec4(0.0);
+    if (uMode == 1) {
+        hist = texelFetch(uHistory, px, 0);
+    } else if (uMode == 2) {
+        // From a fixed eye the image is a function of the ray direction
+        // alone, so rotations map pixels by direction: push this pixel's
+        // ray through the old VP as a point at infinity. Small translations
+        // reuse the same lookup. The fetch is bilinear, so the caller caps
+        // the history while this mode lasts.
+        vec4 wNear = uCurInvVP * vec4(vNDC, -1.0, 1.0);  wNear /= wNear.w;
+        vec4 wFar  = uCurInvVP * vec4(vNDC,  1.0, 1.0);  wFar  /= wFar.w;
+        vec4 clip = uPrevVP * vec4(normalize(wFar.xyz - wNear.xyz), 0.0);
+        vec2 ndc = clip.xy / clip.w;
+        if (clip.w > 0.0 && all(lessThan(abs(ndc), vec2(1.0))))
+            hist = texture(uHistory, ndc * 0.5 + 0.5);
+    }
+
+    float n = min(hist.a, uMaxCount);
+    FragColor = vec4((hist.rgb * n + cur) / (n + 1.0), n + 1.0);
+}
@@ -23,6 +23,7 @@ int main() {
         // platform layer should feed E with events (afterwards process)
 
         glfwPollEvents();
+        if (!E.begin_frame_input()) break; // replay ran out
         E.process_events();
 
         /**
@@ -31,9 +32,19 @@ int main() {
          * hence we update with fixed delta T.
          */
     
-        E.time_now = now_seconds(); 
-        double frame = E.time_now - E.time_prev; // grab how many unprocessed time is left
-        if (frame > 0.25) frame = 0.25; // clamp for hitches 
+        double frame = 0.0;
+        if (E.replaying) {
+            // recorded timeline: same ticks, same shader time, same camera path
+            E.time_now = E.input.time;
+            frame = E.input.dt;
+        } else {
+            E.time_now = now_seconds(); 
+            frame = E.time_now - E.time_prev; // grab how many unprocessed time is left
+            if (frame > 0.25) frame = 0.25; // clamp for hitches 
+            E.input.time = E.time_now;
+            E.input.dt = frame;
+        }
+        if (E.tracing) E.trace.begin_frame(E.time_now, frame);
 
         E.time_prev = E.time_now;
         E.accumulator  += frame; 
@@ -45,6 +56,7 @@ int main() {
 
         E.update_variable(frame); // this is for camera smoothing or lerps.
         E.render();
+        E.end_frame_input(); // record this frame's input
 
         // swap buffers, OS events 
     }
@@ -93,6 +93,43 @@ struct Camera {
       return getProj() * getView();
   }
 
+  /**
+   * Inverse View-Projection, built in closed form
+   * ---------------------------------------------
+   * V is a rigid transform, so V^-1 = T(position) * R(orientation).
+   * P^-1 for the symmetric perspective above is
+   *   [ 1/P00  0      0       0      ]
+   *   [ 0      1/P11  0       0      ]
+   *   [ 0      0      0      -1      ]
+   *   [ 0      0      1/P23   P22/P23]
+   * which avoids a general 4x4 inverse per frame.
+   */
+  glm::mat4 getInvView() const {
+    glm::mat4 m = glm::mat4_cast(orientation);
+    m[3] = glm::vec4(position, 1.0f);
+    return m;
+  }
+
+  glm::mat4 getInvProj() const {
+    return invPerspective(getProj());
+  }
+
+  // closed-form inverse of any glm::perspective() matrix
+  static glm::mat4 invPerspective(const glm::mat4& P) {
+    // glm is column-major: P[col][row]
+    glm::mat4 m(0.0f);
+    m[0][0] = 1.0f / P[0][0];
+    m[1][1] = 1.0f / P[1][1];
+    m[3][2] = -1.0f;
+    m[2][3] = 1.0f / P[3][2];
+    m[3][3] = P[2][2] / P[3][2];
+    return m;
+  }
+
+  glm::mat4 getInvViewProj() const {
+    return getInvView() * getInvProj();
+  }
+
   // using quaternions to update vectors
   void updateVectors() {
     front = glm::normalize(orientation * glm::vec3(0, 0, -1));
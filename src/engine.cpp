@@ -1,5 +1,9 @@
 #include "engine.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
 #include <iostream>
+#include <string>
 
 bool Engine::on_enter(EngineState s) {
   switch (s) {
@@ -69,6 +73,7 @@ bool Engine::on_enter(EngineState s) {
       int fbw = 0, fbh = 0;
       glfwGetFramebufferSize(window, &fbw, &fbh);
       glViewport(0, 0, fbw, fbh);
+      width = fbw; height = fbh;
 
       glfwShowWindow(window);
 
@@ -96,6 +101,18 @@ bool Engine::on_enter(EngineState s) {
       camera.position = glm::vec3(0.0f, 0.0f, 3.0f);
       camera.updateVectors();
 
+      if (const char* env = std::getenv("BH_SDF_PRIMS")) {
+        const int n = std::atoi(env);
+        if (n >= 0) sdfPrims = n;
+      }
+
+      if (const char* env = std::getenv("BH_CAPTURE_SIZE")) {
+        const int size = std::atoi(env);
+        if (size >= 16) captureSize = size;
+      }
+
+      setup_record_replay();
+
       return true;
     };
 
@@ -104,7 +121,9 @@ bool Engine::on_enter(EngineState s) {
     case EngineState::Suspended: std::cout << "[enter] Suspended\n"; return true;
     case EngineState::ShuttingDown: {
       std::cout << "[enter] Shutting Down\n"; 
-      
+
+      finish_record_replay();
+      particles.shutdown();
       renderer.shutdown();
       shaders.shutdown();
 
@@ -142,19 +161,100 @@ void Engine::go(EngineState next) {
 }
 
 void Engine::process_events() {
+  input_polled = glfwGetTime();
   while(!events.empty()) {
     WindowEvent e = events.front(); events.pop(); // grap the first event, and remove 
+    if (!replaying) input.events.push_back(e);
     switch (e.type) {
       case WindowEvent::Close : running = false; break; 
       case WindowEvent::Resize :  width = e.a; height = e.b;  glViewport(0,0,width,height); break; 
       case WindowEvent::FocusLost : if (state == EngineState::Running) go(EngineState::Suspended); break; 
       case WindowEvent::FocusGained : if (state == EngineState::Suspended) go(EngineState::Running); break; 
       case WindowEvent::KeyDown : {
-        if (e.a == 256 /*Esc*/) go(EngineState::ShuttingDown); 
+        // main() runs the ShuttingDown transition once the loop exits
+        if (e.a == 256 /*Esc*/) running = false; 
         if (e.a == 'P') { 
           if (state == EngineState::Running) go(EngineState::Paused); 
           else if (state == EngineState::Paused) go(EngineState::Running);
         }
+        if (e.a == 'H') {
+          if (!showRayStats && !renderer.rmStatsProg && !renderer.init_ray_stats(shaders)) {
+            std::cout << "Ray stats init failed!\n";
+            break;
+          }
+          showRayStats = !showRayStats;
+          statsLastReport = time_now;
+          std::cout << "[stats] heatmap " << (showRayStats ? "on" : "off") << "\n";
+        }
+        if (e.a == 'T') {
+          logFrameTimes = !logFrameTimes;
+          sampleToSwapSum = submitSum = 0.0; timingFrames = 0;
+          timingLastReport = time_now;
+          std::cout << "[timing] " << (logFrameTimes ? "on" : "off") << "\n";
+        }
+        if (e.a == 'Y') {
+          lateLatch = !lateLatch;
+          sampleToSwapSum = submitSum = 0.0; timingFrames = 0;
+          timingLastReport = time_now;
+          std::cout << "[timing] late latch " << (lateLatch ? "on" : "off") << "\n";
+        }
+        if (e.a == GLFW_KEY_F5 || e.a == GLFW_KEY_F6 || e.a == GLFW_KEY_F7) {
+          if (!renderer.multiView.prog && !renderer.multiView.init(shaders)) {
+            std::cout << "Multi-view init failed!\n";
+            break;
+          }
+          captureLayout = (e.a == GLFW_KEY_F5) ? MultiView::Layout::Stereo
+                        : (e.a == GLFW_KEY_F6) ? MultiView::Layout::Cubemap
+                                               : MultiView::Layout::Equirect;
+          capturePending = true;   // taken in render() once FrameData is committed
+        }
+        if (e.a == 'C') {
+          if (!accumulate && !renderer.accum.accumProg && !renderer.init_accum(shaders)) {
+            std::cout << "Accumulation init failed!\n";
+            break;
+          }
+          accumulate = !accumulate;
+          renderer.accum.reset();
+          accumLogged = 0;
+          std::cout << "[accum] " << (accumulate ? "on" : "off") << "\n";
+        }
+        if (e.a == 'G') {
+          if (!showSdf && !renderer.sdfScene.prog && !renderer.init_sdf(shaders, sdfPrims, seed)) {
+            std::cout << "SDF scene init failed!\n";
+            break;
+          }
+          showSdf = !showSdf;
+          std::cout << "[sdf] " << (showSdf ? "on" : "off") << "\n";
+        }
+        if (e.a == 'B' && showSdf) sdfBenchPending = true;   // run in render(), FrameData needed
+        if (e.a == 'L') {
+          if (!lensObjects && !renderer.warpLens.composeProg && !renderer.init_lens(shaders)) {
+            std::cout << "Lens init failed!\n";
+            break;
+          }
+          lensObjects = !lensObjects;
+          renderer.warpLens.invalidate();
+          std::cout << "[lens] " << (lensObjects ? "on" : "off");
+          if (!lensObjects) std::cout << ", " << renderer.warpLens.rebuilds << " warp traces";
+          std::cout << "\n";
+        }
+        if (e.a == 'O') {
+          if (!showParticles && !renderer.partProg && !renderer.init_particles(shaders)) {
+            std::cout << "Particles init failed!\n";
+            break;
+          }
+          showParticles = !showParticles;
+          if (showParticles && particles.count != particleCount) particles.init(particleCount, seed);
+          particleLastReport = time_now;
+          std::cout << "[particles] " << (showParticles ? "on" : "off") << "\n";
+        }
+        if (e.a == GLFW_KEY_LEFT_BRACKET || e.a == GLFW_KEY_RIGHT_BRACKET) {
+          if (e.a == GLFW_KEY_RIGHT_BRACKET && particleCount < (size_t(1) << 22)) particleCount *= 2;
+          if (e.a == GLFW_KEY_LEFT_BRACKET  && particleCount > 1024) particleCount /= 2;
+          if (showParticles) particles.init(particleCount, seed);
+          particleLastReport = time_now;
+          std::cout << "[particles] " << particleCount << "\n";
+        }
 
         break;
       }
@@ -172,24 +272,31 @@ void Engine::setup_input_callbacks() {
     const float dx = static_cast<float>(x - E->lastMouseX);
     const float dy = static_cast<float>(y - E->lastMouseY);
     E->lastMouseX = x; E->lastMouseY = y; 
+    if (E->replaying) return;
 
-    // w,h are FRAMEBUFFER (pixels). Keep E->width/height as window points:
-    int winW=0, winH=0;
-    glfwGetWindowSize(win, &winW, &winH);
-    E->width = winW; 
-    E->height = winH;
+    E->pendingMouseDx += dx;
+    E->pendingMouseDy += dy;
 
-    E->camera.processMouse(dx, dy);
+  });
 
+  glfwSetKeyCallback(window, [](GLFWwindow* win, int key, int /*scancode*/, int action, int mods) {
+    auto* E = static_cast<Engine*>(glfwGetWindowUserPointer(win));
+    if (!E || action == GLFW_REPEAT) return;
+    E->push_event({action == GLFW_PRESS ? WindowEvent::KeyDown : WindowEvent::KeyUp, key, mods});
   });
 
-  // Window Resize -> keep aspect current
+  // Window Resize -> routed through the event queue so it can be recorded;
+  // render() keeps the aspect current
   glfwSetFramebufferSizeCallback(window, [](GLFWwindow* win, int w, int h) {
+    auto* E = static_cast<Engine*>(glfwGetWindowUserPointer(win));
+    if (!E || w <= 0 || h <= 0) return;
+    E->push_event({WindowEvent::Resize, w, h});
+  });
+
+  glfwSetWindowFocusCallback(window, [](GLFWwindow* win, int focused) {
     auto* E = static_cast<Engine*>(glfwGetWindowUserPointer(win));
     if (!E) return;
-    E->width = w; E->height = h;  
-    glViewport(0, 0, w, h);
-    E->camera.aspect = (h > 0) ? (float)w / (float) h : E->camera.aspect;
+    E->push_event({focused ? WindowEvent::FocusGained : WindowEvent::FocusLost});
   });
 }
 
@@ -202,19 +309,21 @@ void Engine::update_fixed(double dt) {
   angle += angular_velocity * static_cast<float>(dt);
   if (angle > 3.14159265f) angle -= 6.28318531f;
   if (angle < -3.14159265f) angle += 6.28318531f;
+
+  if (showParticles) particles.step(dt);
 }
 
 void Engine::update_variable(double dt) {
   if (state != EngineState::Running) return;
 
-  // Handle WASD 
-  const bool w = glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS;
-  const bool s = glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS;
-  const bool a = glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS;
-  const bool d = glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS;
+  // Handle WASD (sampled in begin_frame_input, or replayed)
+  const bool w = input.keys & InputFrame::KEY_W;
+  const bool s = input.keys & InputFrame::KEY_S;
+  const bool a = input.keys & InputFrame::KEY_A;
+  const bool d = input.keys & InputFrame::KEY_D;
 
   // speed boost with Shift
-  const bool boost = glfwGetKey(window, GLFW_KEY_LEFT_SHIFT) == GLFW_PRESS;
+  const bool boost = input.keys & InputFrame::KEY_BOOST;
   const float saved = camera.moveSpeed;
   if (boost) camera.moveSpeed *= 2.5f;
 
@@ -223,17 +332,206 @@ void Engine::update_variable(double dt) {
   if (boost) camera.moveSpeed = saved;
 }
 
+void Engine::latch_camera() {
+  // Late latch: pick up cursor motion that arrived after the top-of-frame poll,
+  // so the view written to the UBO is as fresh as possible. The deltas are
+  // applied here in both modes and on replay, after update_variable's movement.
+  if (lateLatch) glfwPollEvents();
+  if (!replaying) {
+    input.mouseDx += pendingMouseDx;
+    input.mouseDy += pendingMouseDy;
+    pendingMouseDx = pendingMouseDy = 0.0f;
+  }
+  if (input.mouseDx != 0.0f || input.mouseDy != 0.0f)
+    camera.processMouse(input.mouseDx, input.mouseDy);
+}
+
 void Engine::render() {
   if(!window) return; 
   glClearColor(0.1f, 0.12f, 0.2f, 1.0f); 
   glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT); 
 
+  double tSample = -1.0, tBegin = 0.0, tSubmit = 0.0;
+
   if(state == EngineState::Running) {
+    // Wait for a free ring slot *before* sampling input, so a fence stall
+    // doesn't age the camera.
+    FrameData* fd = renderer.frameRing.begin();
+    tBegin = glfwGetTime();
+    latch_camera();
+    // newest input the camera has seen
+    tSample = lateLatch ? glfwGetTime() : input_polled;
+
     camera.aspect = static_cast<float> (width) / static_cast<float> (height);
     // renderer.draw(angle, camera.getViewProj());
 
-    renderer.draw_raymarch(time_now, camera.getViewProj(), camera.position, width, height);
+    if (fd) {
+      fd->invVP      = (accumulate && !showRayStats) ? renderer.accum.jittered_inv_vp(camera, width, height)
+                     : lateLatch                     ? camera.getInvViewProj()
+                                                     : glm::inverse(camera.getViewProj());
+      fd->cameraPos  = camera.position;
+      fd->time       = static_cast<float>(time_now);
+      fd->resolution = glm::vec2(static_cast<float>(width), static_cast<float>(height));
+    }
+    renderer.frameRing.commit();
+
+    // before the trace query opens: the benchmark times with its own
+    if (sdfBenchPending) {
+      renderer.sdfScene.benchmark(renderer.fsVAO, width, height);
+      glViewport(0, 0, width, height);
+      sdfBenchPending = false;
+    }
+    if (tracing) trace.begin_gpu();
+
+    if (showRayStats) {
+      renderer.draw_raymarch_stats(width, height);
+      if (time_now - statsLastReport >= statsInterval) {
+        renderer.rayStats.print_report();
+        statsLastReport = time_now;
+      }
+    } else if (accumulate) {
+      renderer.draw_accumulated(camera, width, height, time_now);
+      const int spp = renderer.accum.samples;
+      if (spp < accumLogged) accumLogged = 0;   // restarted
+      if (spp >= 16 && (spp & (spp - 1)) == 0 && spp != accumLogged) {
+        std::cout << "[accum] " << spp << " samples per pixel\n";
+        accumLogged = spp;
+      }
+    } else if (showSdf) {
+      renderer.draw_sdf();
+    } else if (lensObjects) {
+      renderer.draw_lensed(angle, camera, width, height);
+    } else {
+      renderer.draw_raymarch();
+    }
+
+    if (showParticles) {
+      renderer.draw_particles(particles, camera.getViewProj());
+      if (time_now - particleLastReport >= particleInterval && particles.ticks > 0) {
+        std::printf("[particles] %zu particles  %.3f ms/tick  (%zu threads)\n",
+                    particles.count, particles.tickMsSum / particles.ticks, particles.pool.size());
+        particles.tickMsSum = 0.0; particles.ticks = 0;
+        particleLastReport = time_now;
+      }
+    }
+
+    if (capturePending) {
+      static const char* names[] = { "stereo", "cubemap", "equirect" };
+      char path[64];
+      std::snprintf(path, sizeof(path), "capture_%s_%03d.ppm", names[(int)captureLayout], captureCount++);
+      renderer.multiView.capture(captureLayout, captureSize, camera, renderer.fsVAO, path, width, height);
+      capturePending = false;
+    }
+
+    renderer.frameRing.fence();
+    if (tracing) trace.end_gpu();
+    tSubmit = glfwGetTime();
   }
 
+  if (tracing) trace.end_frame();  // swap excluded, it blocks on vsync
+
   glfwSwapBuffers(window);
-}
\ No newline at end of file
+
+  if (logFrameTimes && tSample >= 0.0) {
+    // input->swap: newest input sample the camera used to swap return. That is the
+    // CPU part of input-to-photon; OS input delivery and scanout are not included.
+    // submit: CPU time from the free ring slot to the fence, latch included.
+    sampleToSwapSum += glfwGetTime() - tSample;
+    submitSum       += tSubmit - tBegin;
+    ++timingFrames;
+
+    if (time_now - timingLastReport >= timingInterval) {
+      const double n = timingFrames * 1e-3;  // averages in ms
+      std::printf("[timing] late latch %s  input->swap %.3f ms  CPU submit %.3f ms  (%d frames)\n",
+                  lateLatch ? "on " : "off", sampleToSwapSum / n, submitSum / n, timingFrames);
+      sampleToSwapSum = submitSum = 0.0; timingFrames = 0;
+      timingLastReport = time_now;
+    }
+  }
+}
+
+void Engine::push_event(const WindowEvent& e) {
+  // a replay owns the input; only let the user bail out with Esc
+  if (replaying && !(e.type == WindowEvent::KeyDown && e.a == 256 /*Esc*/)) return;
+  events.push(e);
+}
+
+void Engine::setup_record_replay() {
+  if (const char* env = std::getenv("BH_SEED")) seed = (uint32_t)std::strtoul(env, nullptr, 10);
+
+  if (const char* path = std::getenv("BH_REPLAY")) {
+    if (!replay.open(path)) {
+      std::cout << "Could not open replay " << path << "\n";
+    } else {
+      replaying = true;
+      seed = replay.seed;
+      tracePath = std::string(path) + ".trace.csv";
+
+      // same resolution as the recording; live resizes are ignored from here on.
+      // The recorded size is in framebuffer pixels, the window is sized in screen
+      // coordinates: scale by the current ratio so HiDPI gets the same pixel count.
+      width = replay.width; height = replay.height;
+      int winW = 0, winH = 0, fbW = 0, fbH = 0;
+      glfwGetWindowSize(window, &winW, &winH);
+      glfwGetFramebufferSize(window, &fbW, &fbH);
+      const double sx = (winW > 0 && fbW > 0) ? (double)fbW / winW : 1.0;
+      const double sy = (winH > 0 && fbH > 0) ? (double)fbH / winH : 1.0;
+      glfwSetWindowSize(window, (int)std::lround(width / sx), (int)std::lround(height / sy));
+      glViewport(0, 0, width, height);
+      glfwSwapInterval(0);
+      std::cout << "[replay] " << path << " (" << width << "x" << height << ", seed " << seed << ")\n";
+    }
+  }
+
+  if (const char* path = std::getenv("BH_RECORD")) {
+    if (replaying) {
+      std::cout << "BH_RECORD ignored while replaying\n";
+    } else if (!recorder.open(path, seed, width, height)) {
+      std::cout << "Could not open recording " << path << "\n";
+    } else {
+      std::cout << "[record] " << path << "\n";
+    }
+  }
+
+  if (const char* path = std::getenv("BH_TRACE")) tracePath = path;
+  if (!tracePath.empty()) tracing = trace.init();
+}
+
+bool Engine::begin_frame_input() {
+  if (replaying) {
+    if (!replay.next(input)) {
+      std::cout << "[replay] done, " << replay.frames << " frames\n";
+      running = false;
+      return false;
+    }
+    for (const WindowEvent& e : input.events) events.push(e);
+  } else {
+    input.clear();
+    if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) input.keys |= InputFrame::KEY_W;
+    if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) input.keys |= InputFrame::KEY_S;
+    if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS) input.keys |= InputFrame::KEY_A;
+    if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS) input.keys |= InputFrame::KEY_D;
+    if (glfwGetKey(window, GLFW_KEY_LEFT_SHIFT) == GLFW_PRESS) input.keys |= InputFrame::KEY_BOOST;
+  }
+  return true;
+}
+
+void Engine::end_frame_input() {
+  recorder.write(input);
+}
+
+void Engine::finish_record_replay() {
+  if (recorder.file) {
+    std::cout << "[record] " << recorder.frames << " frames\n";
+    recorder.close();
+  }
+  replay.close();
+
+  if (tracing) {
+    trace.finish();
+    trace.print_summary();
+    if (trace.write_csv(tracePath)) std::cout << "[trace] " << tracePath << "\n";
+    trace.shutdown();
+    tracing = false;
+  }
+}
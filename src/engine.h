@@ -9,14 +9,10 @@
 #include "renderer.h"
 #include "shader_library.h"
 #include "camera.h"
+#include "input_record.h"
+#include "frame_trace.h"
 
 
-struct WindowEvent {
-  enum Type {Close, Resize, FocusLost, FocusGained, KeyDown, KeyUp} type; 
-
-  int a = 0; int b = 0; /* modifers for event type */
-};
-
 enum class EngineState : uint8_t { 
   Boot, InitGL, Loading, Running, Paused, Suspended, ShuttingDown 
 };
@@ -35,6 +31,8 @@ struct Engine {
   bool captureMouse = true;
   bool firstMouse = true;
   double lastMouseX = 0.0, lastMouseY = 0.0; 
+  // cursor motion since the last latch; applied to the camera right before submission
+  float pendingMouseDx = 0.0f, pendingMouseDy = 0.0f;
 
   void setup_input_callbacks();
 
@@ -44,6 +42,63 @@ struct Engine {
 
   float angle = 0.0f; 
   float angular_velocity = 1.0f; 
+
+  // 'H': instrumented tracer + iteration heatmap, histogram logged every statsInterval
+  bool showRayStats = false;
+  double statsInterval = 1.0, statsLastReport = 0.0;
+
+  // 'T': log input latency / submit cost averages every timingInterval
+  bool logFrameTimes = false;
+  double timingInterval = 2.0, timingLastReport = 0.0;
+  double sampleToSwapSum = 0.0, submitSum = 0.0;
+  int timingFrames = 0;
+  double input_polled = 0.0;  // glfwGetTime() at the top-of-frame poll
+
+  // 'Y': late latch off skips the second poll (the camera sees only the top-of-frame
+  // input) and inverts VP with glm::inverse, so 'T' can compare the two paths. The mouse
+  // is applied in latch_camera either way, so recordings replay the same camera path.
+  bool lateLatch = true;
+
+  // F5 / F6 / F7: stereo / cubemap / equirect capture, traced in one multi-view pass.
+  // captureSize is the output width (cubemap: face size), BH_CAPTURE_SIZE overrides it.
+  int captureSize = 2048;
+  int captureCount = 0;
+  bool capturePending = false;
+  MultiView::Layout captureLayout = MultiView::Layout::Equirect;
+
+  // 'L': rasterized cubes lensed through the warp map (re-traced only when the camera moves)
+  bool lensObjects = false;
+
+  // 'C': converge the static tracer over frames (jittered samples, float history)
+  bool accumulate = false;
+  int accumLogged = 0;   // last sample count logged
+
+  // 'G': SDF primitive scene instead of the hole (BH_SDF_PRIMS primitives);
+  // 'B' while it is up: benchmark brute force / grid / grid + relaxation
+  bool showSdf = false, sdfBenchPending = false;
+  int sdfPrims = 1024;
+
+  // 'O': SoA test particles on the CPU, drawn as lensed sprites.
+  // '[' / ']' halve / double the count (reseeded, so runs stay comparable).
+  ParticleSystem particles;
+  bool showParticles = false;
+  size_t particleCount = 65536;
+  double particleInterval = 2.0, particleLastReport = 0.0;
+
+  // Record / replay (BH_RECORD, BH_REPLAY, BH_TRACE). While replaying, live input
+  // is ignored (except Esc) and the timeline comes from the file, vsync off.
+  InputFrame input;        // this frame's input, live or replayed
+  InputRecorder recorder;
+  InputReplay replay;
+  FrameTrace trace;
+  bool replaying = false, tracing = false;
+  std::string tracePath;
+  uint32_t seed = 1;       // stored in recordings, for seeded simulation state
+
+  void setup_record_replay();
+  bool begin_frame_input();   // false once a replay runs out
+  void end_frame_input();
+  void finish_record_replay();
   
 
   std::queue<WindowEvent> events;
@@ -52,9 +107,10 @@ struct Engine {
   void on_exit(EngineState s);
   void update_fixed(double dt);
   void update_variable(double dt);
+  void latch_camera();
   void render();
   void process_events();
 
   void go(EngineState next); 
-  void push_event(const WindowEvent& e) { events.push(e);}
+  void push_event(const WindowEvent& e);
 };
\ No newline at end of file
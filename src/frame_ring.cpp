@@ -0,0 +1,99 @@
+#include "frame_ring.h"
+
+#include <cstdio>
+
+bool FrameRing::init() {
+  GLint align = 256;
+  glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &align);
+  if (align <= 0) align = 256;
+  slotSize = ((GLsizeiptr)sizeof(FrameData) + align - 1) / align * align;
+
+  glGenBuffers(1, &ubo);
+  if (!ubo) return false;
+  glBindBuffer(GL_UNIFORM_BUFFER, ubo);
+
+  persistent = GLAD_GL_VERSION_4_4 || GLAD_GL_ARB_buffer_storage;
+  if (persistent) {
+    const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    glBufferStorage(GL_UNIFORM_BUFFER, slotSize * SLOTS, nullptr, flags);
+    mapped = static_cast<unsigned char*>(glMapBufferRange(GL_UNIFORM_BUFFER, 0, slotSize * SLOTS, flags));
+    if (!mapped) {
+      std::fprintf(stderr, "warn: persistent UBO map failed, falling back to per-frame maps\n");
+      persistent = false;
+      // immutable storage can't be respecified, start over with a fresh name
+      glBindBuffer(GL_UNIFORM_BUFFER, 0);
+      glDeleteBuffers(1, &ubo);
+      glGenBuffers(1, &ubo);
+      glBindBuffer(GL_UNIFORM_BUFFER, ubo);
+    }
+  }
+  if (!persistent)
+    glBufferData(GL_UNIFORM_BUFFER, slotSize * SLOTS, nullptr, GL_STREAM_DRAW);
+
+  glBindBuffer(GL_UNIFORM_BUFFER, 0);
+  return true;
+}
+
+FrameData* FrameRing::begin() {
+  if (!ubo) return nullptr;
+
+  // The GPU is at most SLOTS-1 frames behind; normally this returns immediately.
+  if (GLsync f = fences[slot]) {
+    GLenum r = glClientWaitSync(f, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000ull);
+    while (r == GL_TIMEOUT_EXPIRED) r = glClientWaitSync(f, 0, 1000000000ull);
+    glDeleteSync(f);
+    fences[slot] = nullptr;
+  }
+
+  const GLintptr offset = slot * slotSize;
+  if (persistent) return reinterpret_cast<FrameData*>(mapped + offset);
+
+  glBindBuffer(GL_UNIFORM_BUFFER, ubo);
+  mapped = static_cast<unsigned char*>(glMapBufferRange(GL_UNIFORM_BUFFER, offset, slotSize,
+      GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT));
+  glBindBuffer(GL_UNIFORM_BUFFER, 0);
+  return reinterpret_cast<FrameData*>(mapped);
+}
+
+void FrameRing::commit() {
+  if (!ubo) return;
+  if (!persistent && mapped) {
+    glBindBuffer(GL_UNIFORM_BUFFER, ubo);
+    glUnmapBuffer(GL_UNIFORM_BUFFER);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    mapped = nullptr;
+  }
+  glBindBufferRange(GL_UNIFORM_BUFFER, BINDING, ubo, slot * slotSize, sizeof(FrameData));
+}
+
+void FrameRing::fence() {
+  if (!ubo) return;
+  fences[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  slot = (slot + 1) % SLOTS;
+}
+
+void FrameRing::shutdown() {
+  for (GLsync& f : fences) {
+    if (f) { glDeleteSync(f); f = nullptr; }
+  }
+  if (ubo) {
+    if (mapped) {
+      glBindBuffer(GL_UNIFORM_BUFFER, ubo);
+      glUnmapBuffer(GL_UNIFORM_BUFFER);
+      glBindBuffer(GL_UNIFORM_BUFFER, 0);
+      mapped = nullptr;
+    }
+    glDeleteBuffers(1, &ubo); ubo = 0;
+  }
+  slot = 0;
+}
+
+void FrameRing::bind_block(GLuint prog) {
+  if (!prog) return;
+  const GLuint idx = glGetUniformBlockIndex(prog, "FrameData");
+  if (idx == GL_INVALID_INDEX) {
+    std::fprintf(stderr, "warn: FrameData block not found\n");
+    return;
+  }
+  glUniformBlockBinding(prog, idx, BINDING);
+}
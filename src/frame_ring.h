@@ -0,0 +1,67 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+/**
+ * =====================================================
+ * Per-frame uniforms
+ * -----------------------------------------------------
+ * std140 mirror of the block every fullscreen program
+ * declares:
+ *
+ *   layout(std140) uniform FrameData {
+ *       mat4  uInvVP;
+ *       vec3  uCameraPos;
+ *       float uTime;
+ *       vec2  uResolution;
+ *   };
+ *
+ * All programs share one binding point (FrameRing::BINDING),
+ * so a frame is uploaded once no matter how many passes read it.
+ * =====================================================
+ */
+struct FrameData {
+  glm::mat4 invVP;
+  glm::vec3 cameraPos;
+  float     time;
+  glm::vec2 resolution;
+  float     _pad[2];
+};
+static_assert(sizeof(FrameData) == 96, "FrameData must match the std140 block");
+
+/**
+ * Triple-buffered uniform ring.
+ *
+ * With GL_ARB_buffer_storage the buffer is mapped once
+ * (persistent + coherent) and written in place; otherwise each
+ * slot is mapped unsynchronized for the duration of the write.
+ * Either way a fence per slot keeps the CPU from overwriting
+ * data the GPU has not consumed yet.
+ *
+ *   FrameData* fd = ring.begin();   // waits on the slot's fence
+ *   ... fill fd ...
+ *   ring.commit();                  // bind slot to BINDING
+ *   ... draws ...
+ *   ring.fence();                   // after the last reader, advances
+ */
+struct FrameRing {
+  static constexpr int    SLOTS   = 3;
+  static constexpr GLuint BINDING = 0;
+
+  GLuint ubo = 0;
+  GLsizeiptr slotSize = 0;
+  GLsync fences[SLOTS] = {};
+  unsigned char* mapped = nullptr;  // whole ring when persistent, current slot otherwise
+  int  slot = 0;
+  bool persistent = false;
+
+  bool init();
+  FrameData* begin();
+  void commit();
+  void fence();
+  void shutdown();
+
+  // point a program's FrameData block at BINDING
+  static void bind_block(GLuint prog);
+};
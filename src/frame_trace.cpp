@@ -0,0 +1,101 @@
+#include "frame_trace.h"
+
+#include <GLFW/glfw3.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+
+static void collect(GLuint q, FrameTrace::Row& row) {
+  GLuint64 ns = 0;
+  glGetQueryObjectui64v(q, GL_QUERY_RESULT, &ns);
+  row.gpu_ms = (double)ns * 1e-6;
+}
+
+bool FrameTrace::init() {
+  glGenQueries(LAG, queries);
+  rows.clear();
+  return queries[0] != 0;
+}
+
+void FrameTrace::begin_frame(double time, double dt) {
+  frameStart = glfwGetTime();
+  // gpu_ms stays NaN unless a query is opened (the engine is Running)
+  rows.push_back({time, dt * 1e3, 0.0, std::numeric_limits<double>::quiet_NaN()});
+}
+
+void FrameTrace::begin_gpu() {
+  if (!queries[0] || rows.empty() || gpuOpen) return;
+  const int frame = (int)rows.size() - 1;
+  const int slot = frame % LAG;
+
+  // the query LAG frames back is finished by now (or very nearly)
+  if (pending[slot] >= 0) { collect(queries[slot], rows[pending[slot]]); pending[slot] = -1; }
+
+  glBeginQuery(GL_TIME_ELAPSED, queries[slot]);
+  pending[slot] = frame;
+  gpuOpen = true;
+}
+
+void FrameTrace::end_gpu() {
+  if (!gpuOpen) return;
+  glEndQuery(GL_TIME_ELAPSED);
+  gpuOpen = false;
+}
+
+void FrameTrace::end_frame() {
+  if (rows.empty()) return;
+  end_gpu();
+  rows.back().cpu_ms = (glfwGetTime() - frameStart) * 1e3;
+}
+
+void FrameTrace::finish() {
+  end_gpu();
+  for (int i = 0; i < LAG; ++i) {
+    if (pending[i] >= 0) { collect(queries[i], rows[pending[i]]); pending[i] = -1; }
+  }
+}
+
+bool FrameTrace::write_csv(const std::string& path) const {
+  std::FILE* f = std::fopen(path.c_str(), "w");
+  if (!f) return false;
+  std::fprintf(f, "frame,time,dt_ms,cpu_ms,gpu_ms\n");
+  for (size_t i = 0; i < rows.size(); ++i) {
+    const Row& r = rows[i];
+    // frames without a GPU query leave the column empty
+    if (std::isnan(r.gpu_ms)) std::fprintf(f, "%zu,%.6f,%.4f,%.4f,\n", i, r.time, r.dt_ms, r.cpu_ms);
+    else std::fprintf(f, "%zu,%.6f,%.4f,%.4f,%.4f\n", i, r.time, r.dt_ms, r.cpu_ms, r.gpu_ms);
+  }
+  std::fclose(f);
+  return true;
+}
+
+void FrameTrace::print_summary() const {
+  if (rows.empty()) return;
+
+  auto report = [&](const char* name, double Row::*field) {
+    std::vector<double> v;
+    v.reserve(rows.size());
+    double sum = 0.0;
+    for (const Row& r : rows) {
+      if (std::isnan(r.*field)) continue;   // not measured this frame
+      v.push_back(r.*field); sum += r.*field;
+    }
+    if (v.empty()) { std::printf("[trace] %s  no samples\n", name); return; }
+    std::sort(v.begin(), v.end());
+    auto pct = [&](double p) { return v[std::min(v.size() - 1, (size_t)(p * (v.size() - 1) + 0.5))]; };
+    std::printf("[trace] %s  mean %.3f  p50 %.3f  p95 %.3f  p99 %.3f  max %.3f ms\n",
+                name, sum / v.size(), pct(0.50), pct(0.95), pct(0.99), v.back());
+  };
+
+  std::printf("[trace] %zu frames\n", rows.size());
+  report("cpu", &Row::cpu_ms);
+  report("gpu", &Row::gpu_ms);
+}
+
+void FrameTrace::shutdown() {
+  if (queries[0]) { glDeleteQueries(LAG, queries); }
+  for (int i = 0; i < LAG; ++i) { queries[i] = 0; pending[i] = -1; }
+  gpuOpen = false;
+}
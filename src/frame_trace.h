@@ -0,0 +1,44 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+
+/**
+ * =====================================================
+ * Per-frame timing trace
+ * -----------------------------------------------------
+ * One row per frame: engine time, simulated dt, CPU time
+ * from frame start to submission (swap excluded, it blocks
+ * on vsync) and GPU time from a GL_TIME_ELAPSED query around
+ * the frame's passes. Queries are read LAG frames late so
+ * collecting them never stalls the pipeline. Frames that
+ * open no query (engine not Running) have no GPU time.
+ *
+ * write_csv() output is meant to be diffed between builds
+ * replaying the same recording.
+ * =====================================================
+ */
+struct FrameTrace {
+  static constexpr int LAG = 3;
+
+  struct Row { double time, dt_ms, cpu_ms, gpu_ms; };
+  std::vector<Row> rows;
+
+  GLuint queries[LAG] = {};
+  int pending[LAG] = { -1, -1, -1 };   // row waiting on each query
+  bool gpuOpen = false;
+  double frameStart = 0.0;
+
+  bool init();
+  void begin_frame(double time, double dt);
+  void begin_gpu();
+  void end_gpu();
+  void end_frame();               // CPU clock stops here
+  void finish();                  // collect outstanding queries
+
+  bool write_csv(const std::string& path) const;
+  void print_summary() const;
+  void shutdown();
+};
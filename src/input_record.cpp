@@ -0,0 +1,87 @@
+#include "input_record.h"
+
+static constexpr char     MAGIC[4] = { 'B', 'H', 'I', 'R' };
+static constexpr uint32_t VERSION  = 1;
+
+template <typename T>
+static bool put(std::FILE* f, const T& v) { return std::fwrite(&v, sizeof(T), 1, f) == 1; }
+
+template <typename T>
+static bool get(std::FILE* f, T& v) { return std::fread(&v, sizeof(T), 1, f) == 1; }
+
+bool InputRecorder::open(const std::string& path, uint32_t seed, int width, int height) {
+  close();
+  file = std::fopen(path.c_str(), "wb");
+  if (!file) return false;
+
+  std::fwrite(MAGIC, 1, sizeof(MAGIC), file);
+  put(file, VERSION);
+  put(file, seed);
+  put(file, (int32_t)width);
+  put(file, (int32_t)height);
+  frames = 0;
+  return true;
+}
+
+void InputRecorder::write(const InputFrame& f) {
+  if (!file) return;
+  put(file, f.time);
+  put(file, f.dt);
+  put(file, f.keys);
+  put(file, f.mouseDx);
+  put(file, f.mouseDy);
+  put(file, (uint16_t)f.events.size());
+  for (const WindowEvent& e : f.events) {
+    put(file, (uint8_t)e.type);
+    put(file, (int32_t)e.a);
+    put(file, (int32_t)e.b);
+  }
+  ++frames;
+}
+
+void InputRecorder::close() {
+  if (file) { std::fclose(file); file = nullptr; }
+}
+
+bool InputReplay::open(const std::string& path) {
+  close();
+  file = std::fopen(path.c_str(), "rb");
+  if (!file) return false;
+
+  char magic[4] = {};
+  uint32_t version = 0;
+  int32_t w = 0, h = 0;
+  const bool ok = std::fread(magic, 1, sizeof(magic), file) == sizeof(magic)
+               && magic[0] == MAGIC[0] && magic[1] == MAGIC[1]
+               && magic[2] == MAGIC[2] && magic[3] == MAGIC[3]
+               && get(file, version) && version == VERSION
+               && get(file, seed) && get(file, w) && get(file, h);
+  if (!ok) { close(); return false; }
+
+  width = w; height = h;
+  frames = 0;
+  return true;
+}
+
+bool InputReplay::next(InputFrame& f) {
+  if (!file) return false;
+  f.clear();
+
+  uint16_t n = 0;
+  if (!get(file, f.time) || !get(file, f.dt) || !get(file, f.keys) ||
+      !get(file, f.mouseDx) || !get(file, f.mouseDy) || !get(file, n)) return false;
+
+  f.events.reserve(n);
+  for (uint16_t i = 0; i < n; ++i) {
+    uint8_t type = 0; int32_t a = 0, b = 0;
+    if (!get(file, type) || !get(file, a) || !get(file, b)) return false;
+    if (type > WindowEvent::KeyUp) return false;
+    f.events.push_back({(WindowEvent::Type)type, a, b});
+  }
+  ++frames;
+  return true;
+}
+
+void InputReplay::close() {
+  if (file) { std::fclose(file); file = nullptr; }
+}
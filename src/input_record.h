@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+struct WindowEvent {
+  enum Type {Close, Resize, FocusLost, FocusGained, KeyDown, KeyUp} type;
+
+  int a = 0; int b = 0; /* modifers for event type */
+};
+
+/**
+ * =====================================================
+ * Per-frame input
+ * -----------------------------------------------------
+ * Everything the engine consumes from the platform in one
+ * frame. Live runs fill it from GLFW; replays read it back
+ * from a recording, which makes the camera path, fixed-step
+ * simulation and shader time bit-identical between runs.
+ * =====================================================
+ */
+struct InputFrame {
+  enum Key : uint8_t { KEY_W = 1, KEY_S = 2, KEY_A = 4, KEY_D = 8, KEY_BOOST = 16 };
+
+  double time = 0.0;            // Engine::time_now
+  double dt = 0.0;              // clamped frame time fed to the fixed-step loop
+  uint8_t keys = 0;             // Key bits held this frame
+  float mouseDx = 0.0f, mouseDy = 0.0f;   // cursor motion latched this frame
+  std::vector<WindowEvent> events;        // processed this frame, in order
+
+  void clear() { time = dt = 0.0; keys = 0; mouseDx = mouseDy = 0.0f; events.clear(); }
+};
+
+/**
+ * Recording file (host byte order):
+ *
+ *   header : "BHIR" u32 version, u32 seed, i32 width, i32 height
+ *   frame  : f64 time, f64 dt, u8 keys, f32 dx, f32 dy, u16 n,
+ *            n x (u8 type, i32 a, i32 b)
+ */
+struct InputRecorder {
+  std::FILE* file = nullptr;
+  uint64_t frames = 0;
+
+  bool open(const std::string& path, uint32_t seed, int width, int height);
+  void write(const InputFrame& f);
+  void close();
+};
+
+struct InputReplay {
+  std::FILE* file = nullptr;
+  uint64_t frames = 0;
+  uint32_t seed = 0;
+  int width = 0, height = 0;
+
+  bool open(const std::string& path);
+  bool next(InputFrame& f);   // false at end of recording
+  void close();
+};
@@ -0,0 +1,227 @@
+#include "multiview.h"
+#include "frame_ring.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+// forward / up per face, layer order +X -X +Y -Y +Z -Z (matches equirect.frag)
+static const glm::vec3 CUBE_FACES[6][2] = {
+  { { 1, 0, 0}, {0, 1, 0} }, { {-1, 0, 0}, {0, 1, 0} },
+  { { 0, 1, 0}, {0, 0, 1} }, { { 0,-1, 0}, {0, 0,-1} },
+  { { 0, 0, 1}, {0, 1, 0} }, { { 0, 0,-1}, {0, 1, 0} },
+};
+
+// inverse of lookAt(pos, pos + f, u)
+static glm::mat4 inv_look(const glm::vec3& pos, const glm::vec3& f, const glm::vec3& u) {
+  const glm::vec3 r = glm::normalize(glm::cross(f, u));
+  glm::mat4 m(1.0f);
+  m[0] = glm::vec4(r, 0.0f);
+  m[1] = glm::vec4(glm::cross(r, f), 0.0f);
+  m[2] = glm::vec4(-f, 0.0f);
+  m[3] = glm::vec4(pos, 1.0f);
+  return m;
+}
+
+// copy one bottom-up RGBA8 readback into a top-down RGB8 image at column x0
+static void put_layer(const unsigned char* layer, int lw, int lh, std::vector<unsigned char>& rgb, int outW, int x0) {
+  for (int y = 0; y < lh; ++y) {
+    const unsigned char* src = layer + (size_t)(lh - 1 - y) * lw * 4;
+    unsigned char* dst = rgb.data() + ((size_t)y * outW + x0) * 3;
+    for (int x = 0; x < lw; ++x) {
+      dst[x * 3 + 0] = src[x * 4 + 0];
+      dst[x * 3 + 1] = src[x * 4 + 1];
+      dst[x * 3 + 2] = src[x * 4 + 2];
+    }
+  }
+}
+
+static bool write_ppm(const std::string& path, int w, int h, const std::vector<unsigned char>& rgb) {
+  std::FILE* f = std::fopen(path.c_str(), "wb");
+  if (!f) return false;
+  std::fprintf(f, "P6\n%d %d\n255\n", w, h);
+  const bool ok = std::fwrite(rgb.data(), 1, rgb.size(), f) == rgb.size();
+  std::fclose(f);
+  return ok;
+}
+
+bool MultiView::init(ShaderLibrary& lib) {
+  prog        = lib.get_raymarch_multiview().id;
+  resolveProg = lib.get_equirect_resolve().id;
+  if (!prog || !resolveProg) return false;
+
+  FrameRing::bind_block(prog);
+  const GLuint idx = glGetUniformBlockIndex(prog, "ViewData");
+  if (idx == GL_INVALID_INDEX) {
+    std::fprintf(stderr, "warn: ViewData block not found\n");
+    return false;
+  }
+  glUniformBlockBinding(prog, idx, BINDING);
+
+  uFacesLoc = glGetUniformLocation(resolveProg, "uFaces");
+
+  glGenBuffers(1, &viewUBO);
+  glBindBuffer(GL_UNIFORM_BUFFER, viewUBO);
+  glBufferData(GL_UNIFORM_BUFFER, sizeof(ViewData), nullptr, GL_DYNAMIC_DRAW);
+  glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+  glGenFramebuffers(1, &fbo);
+  glGenTextures(1, &layerTex);
+  glGenFramebuffers(1, &resolveFBO);
+  glGenTextures(1, &resolveTex);
+  return viewUBO && fbo && layerTex && resolveFBO && resolveTex;
+}
+
+bool MultiView::trace(const ViewData& views, int w, int h, GLuint fsVAO) {
+  glBindBuffer(GL_UNIFORM_BUFFER, viewUBO);
+  glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(ViewData), &views);
+  glBindBuffer(GL_UNIFORM_BUFFER, 0);
+  glBindBufferBase(GL_UNIFORM_BUFFER, BINDING, viewUBO);
+
+  glBindTexture(GL_TEXTURE_2D_ARRAY, layerTex);
+  glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA16F, w, h, views.count, 0, GL_RGBA, GL_HALF_FLOAT, nullptr);
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+  // layered attachment: gl_Layer in multiview.geom picks the view
+  glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+  glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, layerTex, 0);
+  if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+    std::fprintf(stderr, "warn: multiview framebuffer incomplete\n");
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    return false;
+  }
+
+  // the full viewport keeps vNDC per pixel; the scissor picks the tile
+  glViewport(0, 0, w, h);
+  glUseProgram(prog);
+  glBindVertexArray(fsVAO);
+  glEnable(GL_SCISSOR_TEST);
+  for (int y = 0; y < h; y += TILE) {
+    for (int x = 0; x < w; x += TILE) {
+      glScissor(x, y, std::min(TILE, w - x), std::min(TILE, h - y));
+      glDrawArrays(GL_TRIANGLES, 0, 3);
+      glFlush();
+    }
+  }
+  glDisable(GL_SCISSOR_TEST);
+  glBindVertexArray(0);
+  glUseProgram(0);
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  return true;
+}
+
+bool MultiView::capture(Layout layout, int size, const Camera& cam, GLuint fsVAO,
+                        const std::string& path, int width, int height) {
+  if (!prog || !fsVAO || size < 2) return false;
+
+  GLint maxTex = 0;
+  glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTex);
+
+  ViewData views{};
+  int lw = 0, lh = 0;
+
+  if (layout == Layout::Stereo) {
+    // parallel eyes, same orientation, offset along the camera's right vector
+    lw = size / 2;
+    lh = std::max(1, (int)(lw / cam.aspect + 0.5f));
+    Camera eye = cam;
+    eye.aspect = (float)lw / (float)lh;
+    for (int i = 0; i < 2; ++i) {
+      eye.position = cam.position + cam.right * (i == 0 ? -0.5f : 0.5f) * eyeSeparation;
+      views.invVP[i]  = eye.getInvViewProj();
+      views.camPos[i] = glm::vec4(eye.position, 1.0f);
+    }
+    views.count = 2;
+  } else {
+    // cube faces around the camera position, world aligned
+    lw = lh = (layout == Layout::Cubemap) ? size : std::max(16, size / 4);
+    const glm::mat4 invP = Camera::invPerspective(
+        glm::perspective(glm::radians(90.0f), 1.0f, cam.nearPlane, cam.farPlane));
+    for (int i = 0; i < 6; ++i) {
+      views.invVP[i]  = inv_look(cam.position, CUBE_FACES[i][0], CUBE_FACES[i][1]) * invP;
+      views.camPos[i] = glm::vec4(cam.position, 1.0f);
+    }
+    views.count = 6;
+  }
+
+  if (lw > maxTex || lh > maxTex) {
+    std::fprintf(stderr, "warn: capture size %d exceeds GL_MAX_TEXTURE_SIZE %d\n", std::max(lw, lh), maxTex);
+    return false;
+  }
+
+  const bool traced = trace(views, lw, lh, fsVAO);
+
+  int outW = 0, outH = 0;
+  std::vector<unsigned char> rgb;
+
+  if (traced && layout != Layout::Equirect) {
+    // side-by-side eyes / horizontal strip of faces; read back one layer at a
+    // time as RGBA8 (GL clamps and rounds like the PPM needs), not the whole
+    // float array
+    outW = lw * views.count; outH = lh;
+    rgb.resize((size_t)outW * outH * 3);
+    std::vector<unsigned char> rgba((size_t)lw * lh * 4);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, resolveFBO);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    for (int i = 0; i < views.count; ++i) {
+      glFramebufferTextureLayer(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, layerTex, 0, i);
+      glReadPixels(0, 0, lw, lh, GL_RGBA, GL_UNSIGNED_BYTE, rgba.data());
+      put_layer(rgba.data(), lw, lh, rgb, outW, i * lw);
+    }
+    glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, 0, 0);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+  } else if (traced) {
+    outW = size; outH = size / 2;
+    glBindTexture(GL_TEXTURE_2D, resolveTex);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, outW, outH, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, resolveFBO);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, resolveTex, 0);
+    glViewport(0, 0, outW, outH);
+
+    glUseProgram(resolveProg);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, layerTex);
+    if (uFacesLoc >= 0) glUniform1i(uFacesLoc, 0);
+    glBindVertexArray(fsVAO);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    glBindVertexArray(0);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    glUseProgram(0);
+
+    std::vector<unsigned char> rgba((size_t)outW * outH * 4);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glReadPixels(0, 0, outW, outH, GL_RGBA, GL_UNSIGNED_BYTE, rgba.data());
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    rgb.resize((size_t)outW * outH * 3);
+    put_layer(rgba.data(), outW, outH, rgb, outW, 0);
+  }
+
+  glViewport(0, 0, width, height);
+  if (!traced) return false;
+
+  if (!write_ppm(path, outW, outH, rgb)) {
+    std::fprintf(stderr, "warn: could not write %s\n", path.c_str());
+    return false;
+  }
+  std::printf("[capture] %s (%dx%d, %d views in one pass)\n", path.c_str(), outW, outH, views.count);
+  return true;
+}
+
+void MultiView::shutdown() {
+  if (viewUBO) { glDeleteBuffers(1, &viewUBO); viewUBO = 0; }
+  if (layerTex) { glDeleteTextures(1, &layerTex); layerTex = 0; }
+  if (resolveTex) { glDeleteTextures(1, &resolveTex); resolveTex = 0; }
+  if (fbo) { glDeleteFramebuffers(1, &fbo); fbo = 0; }
+  if (resolveFBO) { glDeleteFramebuffers(1, &resolveFBO); resolveFBO = 0; }
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <string>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "shader_library.h"
+#include "camera.h"
+
+/**
+ * =====================================================
+ * Single-pass multi-view capture
+ * -----------------------------------------------------
+ * Traces up to MAX_VIEWS cameras with one draw: a geometry
+ * shader (multiview.geom) replicates the fullscreen triangle
+ * into one layer per view of an RGBA16F texture array, and the
+ * tracer picks its inverse VP / eye position out of the ViewData
+ * block by gView. FrameData (time etc.) is shared by all views.
+ *
+ *   Stereo   : 2 layers, eyes offset along camera.right,
+ *              side-by-side, size pixels wide, camera aspect per eye
+ *   Cubemap  : 6 x 90 degree faces, +X -X +Y -Y +Z -Z strip
+ *   Equirect : the cubemap, resolved to size x size/2 lat-long
+ *
+ * Large captures are traced in TILE x TILE scissor tiles, one
+ * draw (all layers) each and flushed in between, so no single
+ * submission runs long enough to trip the GPU watchdog.
+ *
+ * Output is a binary PPM written to the given path.
+ * =====================================================
+ */
+struct MultiView {
+  enum class Layout { Stereo, Cubemap, Equirect };
+
+  static constexpr int    MAX_VIEWS = 6;
+  static constexpr GLuint BINDING   = 1;   // FrameRing::BINDING is 0
+  static constexpr int    TILE      = 256; // pixels per side and layer, per draw
+
+  // std140 mirror of the ViewData block
+  struct ViewData {
+    glm::mat4 invVP[MAX_VIEWS];
+    glm::vec4 camPos[MAX_VIEWS];
+    int       count;
+    int       _pad[3];
+  };
+  static_assert(sizeof(ViewData) == 496, "ViewData must match the std140 block");
+
+  GLuint prog = 0, resolveProg = 0;
+  GLuint viewUBO = 0;
+  GLuint fbo = 0, layerTex = 0;         // layered target
+  GLuint resolveFBO = 0, resolveTex = 0;
+  int uFacesLoc = -1;
+
+  float eyeSeparation = 0.065f;   // scene units
+
+  bool init(ShaderLibrary& lib);
+
+  // FrameData must already be committed; restores the default framebuffer
+  // and a width x height viewport before returning.
+  bool capture(Layout layout, int size, const Camera& cam, GLuint fsVAO,
+               const std::string& path, int width, int height);
+
+  // views.count layers of w x h into layerTex, one draw per tile
+  bool trace(const ViewData& views, int w, int h, GLuint fsVAO);
+
+  void shutdown();
+};
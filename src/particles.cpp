@@ -0,0 +1,165 @@
+#include "particles.h"
+
+#include <chrono>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define BH_PARTICLES_SSE 1
+#endif
+
+// lowbias32 integer hash
+static inline uint32_t hash_u32(uint32_t a) {
+  a ^= a >> 16; a *= 0x7feb352du;
+  a ^= a >> 15; a *= 0x846ca68bu;
+  a ^= a >> 16;
+  return a;
+}
+
+// uniform [0,1) from (seed, particle, generation, draw)
+static inline float rand01(uint32_t seed, uint32_t idx, uint32_t gen, uint32_t k) {
+  const uint32_t h = hash_u32(seed ^ hash_u32(idx ^ hash_u32(gen * 0x9E3779B9u + k)));
+  return (float)(h >> 8) * (1.0f / 16777216.0f);
+}
+
+// speed of a circular orbit at r (r > 3 GM)
+static inline float v_circular(float r) {
+  const float u = ParticleSystem::GM / r;
+  return std::sqrt(u / (1.0f - 3.0f * u));
+}
+
+void ParticleSystem::init(size_t n, uint32_t s) {
+  seed = s;
+  count = n;
+  x.assign(n, 0.0f); y.assign(n, 0.0f); z.assign(n, 0.0f);
+  vx.assign(n, 0.0f); vy.assign(n, 0.0f); vz.assign(n, 0.0f);
+  gen.assign(n, 0u);
+  for (size_t i = 0; i < n; ++i) spawn(i);
+
+  if (pool.threads.empty()) {
+    const unsigned hw = std::thread::hardware_concurrency();
+    pool.start(hw > 1 ? hw - 1 : 0);
+  }
+  tickMsSum = 0.0; ticks = 0;
+}
+
+void ParticleSystem::spawn(size_t i) {
+  const uint32_t idx = (uint32_t)i, g = gen[i];
+  const float u0 = rand01(seed, idx, g, 0), u1 = rand01(seed, idx, g, 1);
+  const float u2 = rand01(seed, idx, g, 2), u3 = rand01(seed, idx, g, 3);
+
+  const float phi = 6.2831853f * u1;
+  const float c = std::cos(phi), s = std::sin(phi);
+
+  if (rand01(seed, idx, g, 4) < 0.9f) {
+    // thin disk, same sense of rotation as the shader's disk: v along (-sin, 0, cos)
+    const float r = R_IN + (R_OUT - R_IN) * u0 * u0;
+    const float v = v_circular(r) * (0.97f + 0.06f * u2);
+    x[i] = r * c;  y[i] = (u3 - 0.5f) * 0.02f * r;  z[i] = r * s;
+    vx[i] = -s * v; vy[i] = 0.0f;                  vz[i] = c * v;
+  } else {
+    // infalling clump: sub-circular speed on an inclined orbit from the outskirts
+    const float r = R_OUT * (1.0f + u0);
+    const float v = v_circular(r) * (0.4f + 0.4f * u2);
+    const float inc = (u3 - 0.5f) * 2.0f;          // radians, about the x axis
+    const float ci = std::cos(inc), si = std::sin(inc);
+    const float px = r * c, pz = r * s, qx = -s * v, qz = c * v;
+    x[i]  = px;  y[i]  = -pz * si;  z[i]  = pz * ci;
+    vx[i] = qx;  vy[i] = -qz * si;  vz[i] = qz * ci;
+  }
+}
+
+#if BH_PARTICLES_SSE
+// same operation order as accel() below, so both paths round identically
+static inline void accel4(__m128 px, __m128 py, __m128 pz, __m128 qx, __m128 qy, __m128 qz,
+                          __m128& ax, __m128& ay, __m128& az) {
+  const __m128 r2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(px, px), _mm_mul_ps(py, py)), _mm_mul_ps(pz, pz));
+  const __m128 lx = _mm_sub_ps(_mm_mul_ps(py, qz), _mm_mul_ps(pz, qy));
+  const __m128 ly = _mm_sub_ps(_mm_mul_ps(pz, qx), _mm_mul_ps(px, qz));
+  const __m128 lz = _mm_sub_ps(_mm_mul_ps(px, qy), _mm_mul_ps(py, qx));
+  const __m128 l2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(lx, lx), _mm_mul_ps(ly, ly)), _mm_mul_ps(lz, lz));
+  const __m128 inv_r2 = _mm_div_ps(_mm_set1_ps(1.0f), r2);
+  const __m128 r = _mm_sqrt_ps(r2);
+  const __m128 k = _mm_mul_ps(_mm_div_ps(_mm_mul_ps(_mm_set1_ps(-ParticleSystem::GM), inv_r2), r),
+                              _mm_add_ps(_mm_set1_ps(1.0f), _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(3.0f), l2), inv_r2)));
+  ax = _mm_mul_ps(k, px); ay = _mm_mul_ps(k, py); az = _mm_mul_ps(k, pz);
+}
+#endif
+
+static inline void accel(float px, float py, float pz, float qx, float qy, float qz,
+                         float& ax, float& ay, float& az) {
+  const float r2 = (px * px + py * py) + pz * pz;
+  const float lx = py * qz - pz * qy;
+  const float ly = pz * qx - px * qz;
+  const float lz = px * qy - py * qx;
+  const float l2 = (lx * lx + ly * ly) + lz * lz;
+  const float inv_r2 = 1.0f / r2;
+  const float r = std::sqrt(r2);
+  const float k = ((-ParticleSystem::GM * inv_r2) / r) * (1.0f + (3.0f * l2) * inv_r2);
+  ax = k * px; ay = k * py; az = k * pz;
+}
+
+// kick-drift-kick over [begin, end)
+void ParticleSystem::integrate(size_t begin, size_t end, float h) {
+  const float hh = 0.5f * h;
+  float* X = x.data();  float* Y = y.data();  float* Z = z.data();
+  float* VX = vx.data(); float* VY = vy.data(); float* VZ = vz.data();
+
+  size_t i = begin;
+#if BH_PARTICLES_SSE
+  const __m128 H = _mm_set1_ps(h), HH = _mm_set1_ps(hh);
+  for (; i + 4 <= end; i += 4) {
+    __m128 px = _mm_loadu_ps(X + i),  py = _mm_loadu_ps(Y + i),  pz = _mm_loadu_ps(Z + i);
+    __m128 qx = _mm_loadu_ps(VX + i), qy = _mm_loadu_ps(VY + i), qz = _mm_loadu_ps(VZ + i);
+    __m128 ax, ay, az;
+
+    accel4(px, py, pz, qx, qy, qz, ax, ay, az);
+    qx = _mm_add_ps(qx, _mm_mul_ps(ax, HH)); qy = _mm_add_ps(qy, _mm_mul_ps(ay, HH)); qz = _mm_add_ps(qz, _mm_mul_ps(az, HH));
+    px = _mm_add_ps(px, _mm_mul_ps(qx, H));  py = _mm_add_ps(py, _mm_mul_ps(qy, H));  pz = _mm_add_ps(pz, _mm_mul_ps(qz, H));
+    accel4(px, py, pz, qx, qy, qz, ax, ay, az);
+    qx = _mm_add_ps(qx, _mm_mul_ps(ax, HH)); qy = _mm_add_ps(qy, _mm_mul_ps(ay, HH)); qz = _mm_add_ps(qz, _mm_mul_ps(az, HH));
+
+    _mm_storeu_ps(X + i, px);  _mm_storeu_ps(Y + i, py);  _mm_storeu_ps(Z + i, pz);
+    _mm_storeu_ps(VX + i, qx); _mm_storeu_ps(VY + i, qy); _mm_storeu_ps(VZ + i, qz);
+  }
+#endif
+  for (; i < end; ++i) {
+    float px = X[i], py = Y[i], pz = Z[i], qx = VX[i], qy = VY[i], qz = VZ[i];
+    float ax, ay, az;
+
+    accel(px, py, pz, qx, qy, qz, ax, ay, az);
+    qx = qx + ax * hh; qy = qy + ay * hh; qz = qz + az * hh;
+    px = px + qx * h;  py = py + qy * h;  pz = pz + qz * h;
+    accel(px, py, pz, qx, qy, qz, ax, ay, az);
+    qx = qx + ax * hh; qy = qy + ay * hh; qz = qz + az * hh;
+
+    X[i] = px; Y[i] = py; Z[i] = pz; VX[i] = qx; VY[i] = qy; VZ[i] = qz;
+  }
+
+  // captured or escaped: respawn (seeded by index + generation, so order-independent)
+  for (i = begin; i < end; ++i) {
+    const float r2 = (X[i] * X[i] + Y[i] * Y[i]) + Z[i] * Z[i];
+    if (r2 < R_CAPTURE * R_CAPTURE || r2 > R_ESCAPE * R_ESCAPE || !(r2 == r2)) {
+      ++gen[i];
+      spawn(i);
+    }
+  }
+}
+
+void ParticleSystem::step(double dt) {
+  if (!count) return;
+  using clock = std::chrono::steady_clock;
+  const auto t0 = clock::now();
+
+  const float h = static_cast<float>(dt) * timeScale;
+  pool.run(count, CHUNK, [this, h](size_t begin, size_t end) { integrate(begin, end, h); });
+
+  tickMsSum += std::chrono::duration<double, std::milli>(clock::now() - t0).count();
+  ++ticks;
+}
+
+void ParticleSystem::shutdown() {
+  pool.stop();
+  x.clear(); y.clear(); z.clear(); vx.clear(); vy.clear(); vz.clear(); gen.clear();
+  count = 0;
+}
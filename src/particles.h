@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "worker_pool.h"
+
+/**
+ * =====================================================
+ * Test particles around the hole
+ * -----------------------------------------------------
+ * Massive test particles (disk gas, infalling clumps) on
+ * Schwarzschild orbits, advanced at the engine's fixed tick.
+ * With c = 1 and GM = RS/2 the equation of motion in
+ * Cartesian form (per unit proper time) is
+ *
+ *     a = -GM x / r^3 * (1 + 3 L^2 / r^2),   L = x x v
+ *
+ * i.e. Newton plus the relativistic L^2/r^4 term that gives
+ * perihelion precession and the plunge inside r = 3 RS.
+ * r is the Schwarzschild (areal) radius; the tracer's world
+ * space is isotropic, so particles.vert maps r to rho before
+ * drawing (horizon r = RS at rho = RS/4).
+ *
+ * Storage is SoA so the force kernel runs 4 particles per SSE
+ * op (scalar fallback elsewhere) and the position arrays feed
+ * the instanced sprites directly. Chunks are integrated in
+ * parallel; every particle only touches its own slots and
+ * respawns draw from a counter-based hash of (seed, index,
+ * generation), so a tick gives the same result for any thread
+ * count or chunking.
+ * =====================================================
+ */
+struct ParticleSystem {
+  static constexpr float RS        = 0.8f;        // matches the shaders
+  static constexpr float GM        = 0.5f * RS;
+  static constexpr float R_CAPTURE = RS;          // respawn at the horizon (areal r)
+  static constexpr float R_ESCAPE  = 60.0f * RS;  // ... or once they leave the scene
+  static constexpr float R_IN      = 3.0f * RS;   // ISCO
+  static constexpr float R_OUT     = 15.0f * RS;
+  static constexpr size_t CHUNK    = 4096;        // multiple of the SIMD width
+
+  std::vector<float> x, y, z, vx, vy, vz;
+  std::vector<uint32_t> gen;     // respawns so far, per particle
+  size_t count = 0;
+  uint32_t seed = 1;
+
+  float timeScale = 4.0f;        // scene time per second of engine time
+
+  WorkerPool pool;
+  double tickMsSum = 0.0;        // for the scaling report
+  int ticks = 0;
+
+  void init(size_t n, uint32_t seed);
+  void step(double dt);
+  void shutdown();
+
+  void spawn(size_t i);
+  void integrate(size_t begin, size_t end, float h);
+};
@@ -0,0 +1,198 @@
+#include "ray_stats.h"
+
+#include <algorithm>
+#include <cstdio>
+
+static constexpr int BIN_WIDTH = RayStats::MAX_STEPS / RayStats::HIST_BINS;
+
+static const char* REASON_NAMES[RayStats::ReasonCount] = {
+  "exhausted", "photon-sphere", "horizon", "lambda-max", "escaped"
+};
+
+bool RayStats::init(ShaderLibrary& lib) {
+  viewProg = lib.get_ray_stats_view().id;
+  if (!viewProg) return false;
+
+  uColorLoc    = glGetUniformLocation(viewProg, "uColor");
+  uStatsLoc    = glGetUniformLocation(viewProg, "uStats");
+  uMaxStepsLoc = glGetUniformLocation(viewProg, "uMaxSteps");
+
+  // the shader stays #version 330 and #extension ... : require's these, so a
+  // 4.2+ context is not enough on its own, the ARB string must be advertised
+  atomics   = GLAD_GL_ARB_shader_atomic_counters;
+  atomicOps = atomics && GLAD_GL_ARB_shader_atomic_counter_ops;
+
+  if (atomics) {
+    glGenBuffers(1, &counterBuf);
+    glBindBuffer(GL_ATOMIC_COUNTER_BUFFER, counterBuf);
+    glBufferData(GL_ATOMIC_COUNTER_BUFFER, CounterCount * sizeof(GLuint), nullptr, GL_DYNAMIC_READ);
+    glBindBuffer(GL_ATOMIC_COUNTER_BUFFER, 0);
+  }
+
+  glGenFramebuffers(1, &fbo);
+  glGenTextures(1, &colorTex);
+  glGenTextures(1, &statsTex);
+  if (!fbo || !colorTex || !statsTex) {
+    shutdown();
+    return false;
+  }
+  return true;
+}
+
+bool RayStats::resize(int width, int height) {
+  if (width == fbWidth && height == fbHeight) return true;
+  fbWidth = width; fbHeight = height;
+
+  glBindTexture(GL_TEXTURE_2D, colorTex);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+  // integer textures must not be filtered
+  glBindTexture(GL_TEXTURE_2D, statsTex);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32UI, width, height, 0, GL_RGBA_INTEGER, GL_UNSIGNED_INT, nullptr);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  glBindTexture(GL_TEXTURE_2D, 0);
+
+  glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+  glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, colorTex, 0);
+  glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, statsTex, 0);
+  const GLenum bufs[2] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+  glDrawBuffers(2, bufs);
+  const bool ok = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+  if (!ok) std::fprintf(stderr, "warn: ray stats framebuffer incomplete\n");
+  return ok;
+}
+
+void RayStats::begin() {
+  glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+  glViewport(0, 0, fbWidth, fbHeight);
+
+  const GLuint zero[4] = { 0, 0, 0, 0 };
+  glClearBufferuiv(GL_COLOR, 1, zero);
+
+  if (counterBuf) {
+    const GLuint counters[CounterCount] = {};
+    glBindBuffer(GL_ATOMIC_COUNTER_BUFFER, counterBuf);
+    glBufferSubData(GL_ATOMIC_COUNTER_BUFFER, 0, sizeof(counters), counters);
+    glBindBufferBase(GL_ATOMIC_COUNTER_BUFFER, 0, counterBuf);
+  }
+}
+
+void RayStats::end() {
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void RayStats::draw_heatmap(GLuint fsVAO) {
+  if (!viewProg || !fsVAO) return;
+  glUseProgram(viewProg);
+
+  glActiveTexture(GL_TEXTURE0);
+  glBindTexture(GL_TEXTURE_2D, colorTex);
+  glActiveTexture(GL_TEXTURE1);
+  glBindTexture(GL_TEXTURE_2D, statsTex);
+  if (uColorLoc    >= 0) glUniform1i(uColorLoc, 0);
+  if (uStatsLoc    >= 0) glUniform1i(uStatsLoc, 1);
+  if (uMaxStepsLoc >= 0) glUniform1f(uMaxStepsLoc, (float)MAX_STEPS);
+
+  glBindVertexArray(fsVAO);
+  glDrawArrays(GL_TRIANGLES, 0, 3);
+  glBindVertexArray(0);
+
+  glBindTexture(GL_TEXTURE_2D, 0);
+  glActiveTexture(GL_TEXTURE0);
+  glBindTexture(GL_TEXTURE_2D, 0);
+  glUseProgram(0);
+}
+
+void RayStats::print_report() {
+  if (!fbo || fbWidth <= 0 || fbHeight <= 0) return;
+  const size_t pixels = (size_t)fbWidth * (size_t)fbHeight;
+
+  // Synchronous readback: this stalls the pipeline, fine for a debug overlay.
+  readback.resize(pixels * 4);
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo);
+  glReadBuffer(GL_COLOR_ATTACHMENT1);
+  glPixelStorei(GL_PACK_ALIGNMENT, 4);
+  glReadPixels(0, 0, fbWidth, fbHeight, GL_RGBA_INTEGER, GL_UNSIGNED_INT, readback.data());
+  glReadBuffer(GL_COLOR_ATTACHMENT0);
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+
+  uint64_t hist[HIST_BINS] = {};
+  uint64_t reasons[ReasonCount] = {};
+  uint64_t binSteps[HIST_BINS] = {};
+  uint64_t totalSteps = 0, totalRhs = 0;
+  uint32_t maxSteps = 0;
+
+  for (size_t i = 0; i < pixels; ++i) {
+    const uint32_t steps  = readback[i * 4 + 0];
+    const uint32_t reason = readback[i * 4 + 1];
+    const uint32_t rhs    = readback[i * 4 + 2];
+
+    const int bin = std::min<int>(HIST_BINS - 1, (int)(steps / BIN_WIDTH));
+    hist[bin]++;
+    binSteps[bin] += steps;
+    if (reason < ReasonCount) reasons[reason]++;
+    totalSteps += steps;
+    totalRhs   += rhs;
+    maxSteps = std::max(maxSteps, steps);
+  }
+
+  std::printf("[stats] %dx%d  mean iters %.1f  max %u  rhs evals %llu (%.1f/px)\n",
+              fbWidth, fbHeight, (double)totalSteps / pixels, maxSteps,
+              (unsigned long long)totalRhs, (double)totalRhs / pixels);
+
+  // share of pixels vs share of total work per iteration bucket
+  for (int b = 0; b < HIST_BINS; ++b) {
+    const double pxPct   = 100.0 * hist[b] / pixels;
+    const double costPct = totalSteps ? 100.0 * binSteps[b] / totalSteps : 0.0;
+    char bar[41] = {};
+    const int n = std::min(40, (int)(costPct * 0.4 + 0.5));
+    for (int i = 0; i < n; ++i) bar[i] = '#';
+    std::printf("[stats] %4d-%4d  px %5.1f%%  cost %5.1f%%  %s\n",
+                b * BIN_WIDTH, (b + 1) * BIN_WIDTH - 1, pxPct, costPct, bar);
+  }
+
+  for (int r = 0; r < ReasonCount; ++r)
+    std::printf("[stats] %-13s %5.1f%%\n", REASON_NAMES[r], 100.0 * reasons[r] / pixels);
+
+  if (counterBuf) {
+    // shader atomics are incoherent with buffer reads until a barrier; without
+    // glMemoryBarrier (pre-4.2, no image_load_store) wait for the draw instead
+    if (GLAD_GL_VERSION_4_2 || GLAD_GL_ARB_shader_image_load_store)
+      glMemoryBarrier(GL_ATOMIC_COUNTER_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+    else
+      glFinish();
+
+    GLuint counters[CounterCount] = {};
+    glBindBuffer(GL_ATOMIC_COUNTER_BUFFER, counterBuf);
+    glGetBufferSubData(GL_ATOMIC_COUNTER_BUFFER, 0, sizeof(counters), counters);
+    glBindBuffer(GL_ATOMIC_COUNTER_BUFFER, 0);
+
+    std::printf("[stats] atomic: exhausted %u  photon-sphere %u  horizon %u  lambda-max %u  escaped %u\n",
+                counters[Exhausted], counters[PhotonSphere], counters[Horizon],
+                counters[LambdaMax], counters[Escaped]);
+    if (atomicOps) // 32-bit counters, these wrap on large targets
+      std::printf("[stats] atomic: iterations %u  rhs evals %u\n",
+                  counters[TotalSteps], counters[TotalRhsEvals]);
+  }
+}
+
+void RayStats::drop_atomics(bool keep_counters) {
+  atomicOps = false;
+  if (keep_counters) return;
+  atomics = false;
+  if (counterBuf) { glDeleteBuffers(1, &counterBuf); counterBuf = 0; }
+}
+
+void RayStats::shutdown() {
+  if (counterBuf) { glDeleteBuffers(1, &counterBuf); counterBuf = 0; }
+  if (statsTex) { glDeleteTextures(1, &statsTex); statsTex = 0; }
+  if (colorTex) { glDeleteTextures(1, &colorTex); colorTex = 0; }
+  if (fbo) { glDeleteFramebuffers(1, &fbo); fbo = 0; }
+  fbWidth = fbHeight = 0;
+  readback.clear();
+}
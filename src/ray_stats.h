@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <glad/glad.h>
+
+#include "shader_library.h"
+
+/**
+ * =====================================================
+ * Ray cost counters
+ * -----------------------------------------------------
+ * The instrumented tracer ("raymarch_stats", the regular
+ * tracer compiled with RAY_STATS) renders into an offscreen
+ * target with two attachments:
+ *
+ *   0: RGBA8    traced colour
+ *   1: RGBA32UI uvec4(iterations, reason, rhs evals, 0)
+ *
+ * With GL_ARB_shader_atomic_counters the shader also counts
+ * pixels per termination reason (and, with the _ops extension,
+ * total iterations / rhs evaluations) in an atomic counter
+ * buffer bound at 0. draw_heatmap() overlays the iteration
+ * count on the image; print_report() reads attachment 1 back
+ * and logs a histogram.
+ * =====================================================
+ */
+struct RayStats {
+  // keep in sync with REASON_* in animated_blackhole.frag
+  enum Reason : uint32_t { Exhausted = 0, PhotonSphere, Horizon, LambdaMax, Escaped, ReasonCount };
+  // atomic counter slots: one per Reason, then the _ops totals
+  enum Counter : uint32_t { TotalSteps = ReasonCount, TotalRhsEvals, CounterCount };
+
+  static constexpr int MAX_STEPS = 1200; // compiled into the stats tracer as N_STEPS
+  static constexpr int HIST_BINS = 12;
+
+  GLuint fbo = 0, colorTex = 0, statsTex = 0, counterBuf = 0;
+  GLuint viewProg = 0;
+  int fbWidth = 0, fbHeight = 0;
+  int uColorLoc = -1, uStatsLoc = -1, uMaxStepsLoc = -1;
+
+  bool atomics = false;     // per-reason counters
+  bool atomicOps = false;   // + atomicCounterAddARB totals
+
+  std::vector<uint32_t> readback; // RGBA32UI, fbWidth * fbHeight * 4
+
+  bool init(ShaderLibrary& lib);
+  bool resize(int width, int height);
+
+  void begin();   // bind offscreen target, zero the counters
+  void end();     // back to the default framebuffer
+  void draw_heatmap(GLuint fsVAO);
+  void print_report();
+
+  // step down when the matching shader variant fails to compile
+  void drop_atomics(bool keep_counters);
+
+  void shutdown();
+};
@@ -1,6 +1,7 @@
 #include "renderer.h"
 #include "shader_library.h"
 #include <cstdio> 
+#include <cmath>
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
@@ -105,12 +106,10 @@ bool Renderer::init_raymarch(ShaderLibrary& lib) {
   rmProg = lib.get_raymarch().id;
   if(!rmProg) return false;
 
-  // uniforms
-  uInvVPLoc  = glGetUniformLocation(rmProg, "uInvVP");
-  uTimeLoc   = glGetUniformLocation(rmProg, "uTime");
-  uResLoc    = glGetUniformLocation(rmProg, "uResolution");
-  uCamPosLoc = glGetUniformLocation(rmProg, "uCameraPos");
-  
+  // per-frame uniforms come from the shared UBO ring
+  FrameRing::bind_block(rmProg);
+  if (!frameRing.ubo && !frameRing.init()) return false;
+
   // full-screen triangle
   glGenVertexArrays(1, &fsVAO);
   glGenBuffers(1, &fsVBO);
@@ -124,6 +123,64 @@ bool Renderer::init_raymarch(ShaderLibrary& lib) {
 
 }
 
+bool Renderer::init_ray_stats(ShaderLibrary& lib) {
+  if (!rayStats.init(lib)) return false;
+
+  // atomic ops -> atomic counters -> plain per-pixel stats, first one that compiles
+  rmStatsProg = lib.get_raymarch_stats(rayStats.atomics, rayStats.atomicOps, RayStats::MAX_STEPS).id;
+  while (!rmStatsProg && rayStats.atomics) {
+    std::fprintf(stderr, "warn: ray stats shader with atomic counters%s failed, retrying without\n",
+                 rayStats.atomicOps ? " ops" : "");
+    rayStats.drop_atomics(rayStats.atomicOps);
+    rmStatsProg = lib.get_raymarch_stats(rayStats.atomics, rayStats.atomicOps, RayStats::MAX_STEPS).id;
+  }
+  if (!rmStatsProg) {
+    rayStats.shutdown();   // the next 'H' starts over
+    return false;
+  }
+
+  FrameRing::bind_block(rmStatsProg);
+  return true;
+}
+
+bool Renderer::init_particles(ShaderLibrary& lib) {
+  partProg = lib.get_particles().id;
+  if (!partProg) return false;
+
+  FrameRing::bind_block(partProg);
+  uPartVPLoc   = glGetUniformLocation(partProg, "uVP");
+  uPartSizeLoc = glGetUniformLocation(partProg, "uSize");
+
+  const float corners[8] = { -1.0f, -1.0f,  1.0f, -1.0f,  -1.0f, 1.0f,  1.0f, 1.0f };
+
+  glGenVertexArrays(1, &partVAO);
+  glGenBuffers(1, &partQuadVBO);
+  glGenBuffers(1, &partVBO);
+  if (!partVAO || !partQuadVBO || !partVBO) return false;
+
+  glBindVertexArray(partVAO);
+  glBindBuffer(GL_ARRAY_BUFFER, partQuadVBO);
+  glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+  // layout(location=0) vec2 aCorner
+  glEnableVertexAttribArray(0);
+  glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  glBindVertexArray(0);
+  return true;
+}
+
+bool Renderer::init_lens(ShaderLibrary& lib) {
+  if (!vao && !init_cube(lib)) return false;
+  return warpLens.init(lib);
+}
+
+bool Renderer::init_sdf(ShaderLibrary& lib, int count, uint32_t seed) {
+  return sdfScene.init(lib, count, seed);
+}
+
+bool Renderer::init_accum(ShaderLibrary& lib) {
+  return accum.init(lib);
+}
 
 void Renderer::shutdown() {
   if (vbo) { glDeleteBuffers(1, &vbo); vbo = 0;} 
@@ -131,6 +188,16 @@ void Renderer::shutdown() {
   if (vao) { glDeleteVertexArrays(1, &vao); vao = 0;} 
   if (fsVBO) { glDeleteBuffers(1, &fsVBO); fsVBO = 0; }
   if (fsVAO) { glDeleteVertexArrays(1, &fsVAO); fsVAO = 0; }
+  if (partVBO) { glDeleteBuffers(1, &partVBO); partVBO = 0; }
+  if (partQuadVBO) { glDeleteBuffers(1, &partQuadVBO); partQuadVBO = 0; }
+  if (partVAO) { glDeleteVertexArrays(1, &partVAO); partVAO = 0; }
+  partCapacity = 0;
+  rayStats.shutdown();
+  frameRing.shutdown();
+  multiView.shutdown();
+  warpLens.shutdown();
+  sdfScene.shutdown();
+  accum.shutdown();
 }
 
 void Renderer::draw(float angle_radians, const glm::mat4& VP) {
@@ -151,17 +218,98 @@ void Renderer::draw(float angle_radians, const glm::mat4& VP) {
 }
 
 
-void Renderer::draw_raymarch(double time_sec, const glm::mat4& VP, const glm::vec3& camPos, int width, int height) {
+void Renderer::draw_raymarch() {
   if (!rmProg || !fsVAO) return;
   glUseProgram(rmProg);
-  // Send inverse VP for ray reconstruction
-  glm::mat4 invVP = glm::inverse(VP);
-  if (uInvVPLoc >= 0) glUniformMatrix4fv(uInvVPLoc, 1, GL_FALSE, glm::value_ptr(invVP));
-  if (uTimeLoc  >= 0) glUniform1f(uTimeLoc,  (float)time_sec);
-  if (uResLoc   >= 0) glUniform2f(uResLoc,   (float)width, (float)height);
-  if (uCamPosLoc>= 0) glUniform3fv(uCamPosLoc, 1, glm::value_ptr(camPos));
   glBindVertexArray(fsVAO);
   glDrawArrays(GL_TRIANGLES, 0, 3);
   glBindVertexArray(0);
   glUseProgram(0);
-}
\ No newline at end of file
+}
+
+void Renderer::draw_raymarch_stats(int width, int height) {
+  if (!rmStatsProg || !fsVAO) return;
+  if (!rayStats.resize(width, height)) return;
+
+  rayStats.begin();
+  glUseProgram(rmStatsProg);
+  glBindVertexArray(fsVAO);
+  glDrawArrays(GL_TRIANGLES, 0, 3);
+  glBindVertexArray(0);
+  glUseProgram(0);
+  rayStats.end();
+
+  rayStats.draw_heatmap(fsVAO);
+}
+
+void Renderer::draw_particles(const ParticleSystem& ps, const glm::mat4& VP) {
+  if (!partProg || !partVAO || !ps.count) return;
+  const size_t n = ps.count;
+  const GLsizeiptr axisBytes = (GLsizeiptr)(n * sizeof(float));
+
+  glBindVertexArray(partVAO);
+  glBindBuffer(GL_ARRAY_BUFFER, partVBO);
+  if (n != partCapacity) {
+    glBufferData(GL_ARRAY_BUFFER, axisBytes * 3, nullptr, GL_STREAM_DRAW);
+    // layout(location=1..3) float aX, aY, aZ: one SoA array each, per instance
+    for (GLuint a = 0; a < 3; ++a) {
+      glEnableVertexAttribArray(1 + a);
+      glVertexAttribPointer(1 + a, 1, GL_FLOAT, GL_FALSE, sizeof(float), (void*)(a * axisBytes));
+      glVertexAttribDivisor(1 + a, 1);
+    }
+    partCapacity = n;
+  } else {
+    glBufferData(GL_ARRAY_BUFFER, axisBytes * 3, nullptr, GL_STREAM_DRAW);  // orphan
+  }
+  glBufferSubData(GL_ARRAY_BUFFER, 0,             axisBytes, ps.x.data());
+  glBufferSubData(GL_ARRAY_BUFFER, axisBytes,     axisBytes, ps.y.data());
+  glBufferSubData(GL_ARRAY_BUFFER, axisBytes * 2, axisBytes, ps.z.data());
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+  glUseProgram(partProg);
+  if (uPartVPLoc   >= 0) glUniformMatrix4fv(uPartVPLoc, 1, GL_FALSE, glm::value_ptr(VP));
+  if (uPartSizeLoc >= 0) glUniform1f(uPartSizeLoc, particleSize);
+
+  // additive glow over the traced image, no depth
+  glDisable(GL_DEPTH_TEST);
+  glEnable(GL_BLEND);
+  glBlendFunc(GL_ONE, GL_ONE);
+  glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, (GLsizei)n);
+  glDisable(GL_BLEND);
+  glEnable(GL_DEPTH_TEST);
+
+  glBindVertexArray(0);
+  glUseProgram(0);
+}
+
+void Renderer::draw_lensed(float angle_radians, const Camera& cam, int width, int height) {
+  if (!vao || !fsVAO) return;
+
+  // a ring of cubes just outside the lensing sphere, tumbling like draw()'s
+  static constexpr int COUNT = 12;
+  glm::mat4 models[COUNT];
+  for (int i = 0; i < COUNT; ++i) {
+    const float a = 6.2831853f * (float)i / (float)COUNT;
+    const float r = WarpLens::LENS_RADIUS + 3.0f + 2.0f * (float)(i % 3);
+    const float y = 1.5f * (float)(i % 4) - 2.25f;
+    glm::mat4 M = glm::translate(glm::mat4(1.0f), glm::vec3(r * std::cos(a), y, r * std::sin(a)));
+    M = glm::rotate(M, angle_radians, glm::vec3(0.0f, 1.0f, 0.0f));
+    M = glm::rotate(M, angle_radians * 0.7f, glm::vec3(1.0f, 0.0f, 0.0f));
+    models[i] = glm::scale(M, glm::vec3(2.0f));
+  }
+
+  warpLens.render_env(vao, 36, models, COUNT);
+  warpLens.update_warp(cam.getInvViewProj(), cam.position, width, height, fsVAO);
+
+  glViewport(0, 0, width, height);
+  warpLens.compose(fsVAO);
+}
+
+void Renderer::draw_sdf() {
+  sdfScene.draw(fsVAO);
+}
+
+void Renderer::draw_accumulated(const Camera& cam, int width, int height, double time) {
+  accum.draw(cam, fsVAO, width, height, time);
+  glViewport(0, 0, width, height);
+}
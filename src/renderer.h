@@ -4,22 +4,57 @@
 #include <glm/glm.hpp>
 
 #include "shader_library.h" 
+#include "ray_stats.h"
+#include "frame_ring.h"
+#include "multiview.h"
+#include "particles.h"
+#include "warp_lens.h"
+#include "sdf_scene.h"
+#include "temporal_accum.h"
+#include "camera.h"
 
 struct Renderer {
   GLuint prog = 0, vao = 0, vbo = 0, ebo = 0;
   GLuint rmProg = 0, fsVAO = 0, fsVBO = 0;
+  GLuint rmStatsProg = 0;
+  RayStats rayStats;
+  FrameRing frameRing;   // FrameData for every fullscreen program
+  MultiView multiView;   // stereo / cubemap / equirect captures
+
+  // instanced, lensed particle sprites; partVBO holds x[], y[], z[] back to back
+  GLuint partProg = 0, partVAO = 0, partQuadVBO = 0, partVBO = 0;
+  size_t partCapacity = 0;
+  int uPartVPLoc = -1, uPartSizeLoc = -1;
+  float particleSize = 1.5f;   // pixels
+
+  WarpLens warpLens;     // init_cube's mesh, lensed through a cached warp map
+  SdfScene sdfScene;     // raymarch.frag over a gridded primitive list
+  TemporalAccum accum;   // jittered blackhole.frag samples averaged over frames
 
 
   bool init_triangle(ShaderLibrary& lib);
   bool init_cube(ShaderLibrary& lib);
   bool init_raymarch(ShaderLibrary& lib);
+  bool init_ray_stats(ShaderLibrary& lib);
+  bool init_particles(ShaderLibrary& lib);
+  bool init_lens(ShaderLibrary& lib);
+  bool init_sdf(ShaderLibrary& lib, int count, uint32_t seed);
+  bool init_accum(ShaderLibrary& lib);
 
   int uTransformLoc = -1;                
-  int uInvVPLoc = -1, uTimeLoc = -1, uResLoc = -1, uCamPosLoc = -1; // RM core
 
 
   void draw(float angle_radians, const glm::mat4& VP);
-  void draw_raymarch(double time_sec, const glm::mat4& VP, const glm::vec3& camPos, int width, int hight);
+  // fullscreen passes read the FrameData committed through frameRing
+  void draw_raymarch();
+  // instrumented tracer into rayStats' target, then the heatmap overlay to the screen
+  void draw_raymarch_stats(int width, int height);
+  void draw_particles(const ParticleSystem& ps, const glm::mat4& VP);
+  // spinning cubes around the hole, seen through the tracer's warp map
+  void draw_lensed(float angle_radians, const Camera& cam, int width, int height);
+  void draw_sdf();
+  // FrameData must carry accum.jittered_inv_vp()
+  void draw_accumulated(const Camera& cam, int width, int height, double time);
  
   void shutdown();
 };
\ No newline at end of file
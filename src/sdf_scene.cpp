@@ -0,0 +1,311 @@
+#include "sdf_scene.h"
+#include "frame_ring.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+
+// lowbias32 integer hash
+static inline uint32_t hash_u32(uint32_t a) {
+  a ^= a >> 16; a *= 0x7feb352du;
+  a ^= a >> 15; a *= 0x846ca68bu;
+  a ^= a >> 16;
+  return a;
+}
+
+// uniform [0,1) from (seed, primitive, draw)
+static inline float rand01(uint32_t seed, uint32_t idx, uint32_t k) {
+  const uint32_t h = hash_u32(seed ^ hash_u32(idx ^ hash_u32(k * 0x9E3779B9u)));
+  return (float)(h >> 8) * (1.0f / 16777216.0f);
+}
+
+// half extent of a primitive's bounding box
+static glm::vec3 half_extent(const SdfScene::Prim& p) {
+  if ((int)p.type == SdfScene::Sphere) return glm::vec3(p.size.x);
+  return p.size + glm::vec3(p.round);
+}
+
+static SdfScene::Locs find_locs(GLuint prog) {
+  SdfScene::Locs l;
+  l.prims     = glGetUniformLocation(prog, "uPrims");
+  l.cells     = glGetUniformLocation(prog, "uCells");
+  l.cellPrims = glGetUniformLocation(prog, "uCellPrims");
+  l.primCount = glGetUniformLocation(prog, "uPrimCount");
+  l.gridMin   = glGetUniformLocation(prog, "uGridMin");
+  l.cellSize  = glGetUniformLocation(prog, "uCellSize");
+  l.gridDim   = glGetUniformLocation(prog, "uGridDim");
+  l.margin    = glGetUniformLocation(prog, "uMargin");
+  l.useGrid   = glGetUniformLocation(prog, "uUseGrid");
+  l.omega     = glGetUniformLocation(prog, "uOmega");
+  return l;
+}
+
+bool SdfScene::init(ShaderLibrary& lib, int count, uint32_t s) {
+  prog      = lib.get_sdf_scene(false).id;
+  statsProg = lib.get_sdf_scene(true).id;
+  if (!prog || !statsProg) return false;
+
+  FrameRing::bind_block(prog);
+  FrameRing::bind_block(statsProg);
+  locs      = find_locs(prog);
+  statsLocs = find_locs(statsProg);
+
+  glGenBuffers(1, &primBuf);
+  glGenBuffers(1, &cellBuf);
+  glGenBuffers(1, &cellPrimBuf);
+  glGenTextures(1, &primTex);
+  glGenTextures(1, &cellTex);
+  glGenTextures(1, &cellPrimTex);
+  if (!primBuf || !cellBuf || !cellPrimBuf || !primTex || !cellTex || !cellPrimTex) return false;
+
+  generate(count, s);
+  build_grid();
+  return upload();
+}
+
+void SdfScene::generate(int count, uint32_t s) {
+  seed = s;
+  prims.resize((size_t)std::max(count, 0));
+
+  // an annulus around the hero sphere, ~6 square units per primitive
+  const float rIn = 3.0f;
+  const float rOut = std::sqrt(rIn * rIn + (float)count * 6.0f / 3.14159265f);
+
+  for (int i = 0; i < count; ++i) {
+    const uint32_t idx = (uint32_t)i;
+    Prim& p = prims[i];
+    const float r   = std::sqrt(rIn * rIn + rand01(seed, idx, 0) * (rOut * rOut - rIn * rIn));
+    const float phi = 6.2831853f * rand01(seed, idx, 1);
+    const float sz  = 0.2f + 0.4f * rand01(seed, idx, 2);
+
+    p.type   = (float)std::min((int)(rand01(seed, idx, 3) * 3.0f), (int)RoundBox);
+    p.center = glm::vec3(r * std::cos(phi), -1.0f + sz + 2.0f * rand01(seed, idx, 4), r * std::sin(phi));
+    p.size   = glm::vec3(sz, sz * (0.5f + rand01(seed, idx, 5)), sz);
+    p.round  = 0.0f;
+    if ((int)p.type == RoundBox) { p.round = 0.3f * sz; p.size -= glm::vec3(p.round); }
+    p.albedo = glm::vec3(0.3f) + 0.6f * glm::vec3(rand01(seed, idx, 6), rand01(seed, idx, 7), rand01(seed, idx, 8));
+    p._pad   = 0.0f;
+  }
+}
+
+void SdfScene::build_grid() {
+  using clock = std::chrono::steady_clock;
+  const auto t0 = clock::now();
+
+  glm::vec3 bmin(0.0f), bmax(1.0f);
+  if (!prims.empty()) {
+    bmin = glm::vec3(1e30f); bmax = glm::vec3(-1e30f);
+    for (const Prim& p : prims) {
+      const glm::vec3 e = half_extent(p);
+      bmin = glm::min(bmin, p.center - e);
+      bmax = glm::max(bmax, p.center + e);
+    }
+  }
+
+  // about one primitive per cell, within MAX_DIM per axis
+  const glm::vec3 ext = glm::max(bmax - bmin, glm::vec3(1e-3f));
+  cellSize = std::cbrt(ext.x * ext.y * ext.z / (float)std::max<size_t>(prims.size(), 1));
+  cellSize = std::max(cellSize, std::max(ext.x, std::max(ext.y, ext.z)) / (float)(MAX_DIM - 2));
+  margin = 0.5f * cellSize;
+
+  gridMin = bmin - glm::vec3(margin);
+  gridDim = glm::clamp(glm::ivec3(glm::ceil((ext + 2.0f * margin) / cellSize)), glm::ivec3(1), glm::ivec3(MAX_DIM));
+
+  const size_t nCells = (size_t)gridDim.x * gridDim.y * gridDim.z;
+  cells.assign(nCells * 2, 0);
+
+  // cells touched by a primitive's bounds grown by margin
+  auto range = [&](const Prim& p, glm::ivec3& lo, glm::ivec3& hi) {
+    const glm::vec3 e = half_extent(p) + glm::vec3(margin);
+    lo = glm::clamp(glm::ivec3(glm::floor((p.center - e - gridMin) / cellSize)), glm::ivec3(0), gridDim - 1);
+    hi = glm::clamp(glm::ivec3(glm::floor((p.center + e - gridMin) / cellSize)), glm::ivec3(0), gridDim - 1);
+  };
+  auto cell_index = [&](int x, int y, int z) { return ((size_t)z * gridDim.y + y) * gridDim.x + x; };
+
+  // count, prefix sum, fill
+  glm::ivec3 lo, hi;
+  for (const Prim& p : prims) {
+    range(p, lo, hi);
+    for (int z = lo.z; z <= hi.z; ++z)
+      for (int y = lo.y; y <= hi.y; ++y)
+        for (int x = lo.x; x <= hi.x; ++x) ++cells[cell_index(x, y, z) * 2 + 1];
+  }
+  int32_t total = 0, longest = 0;
+  for (size_t c = 0; c < nCells; ++c) {
+    cells[c * 2] = total;
+    total += cells[c * 2 + 1];
+    longest = std::max(longest, cells[c * 2 + 1]);
+    cells[c * 2 + 1] = 0;
+  }
+  cellPrims.assign((size_t)total, 0);
+  for (size_t i = 0; i < prims.size(); ++i) {
+    range(prims[i], lo, hi);
+    for (int z = lo.z; z <= hi.z; ++z)
+      for (int y = lo.y; y <= hi.y; ++y)
+        for (int x = lo.x; x <= hi.x; ++x) {
+          const size_t c = cell_index(x, y, z);
+          cellPrims[cells[c * 2] + cells[c * 2 + 1]++] = (int32_t)i;
+        }
+  }
+
+  const double ms = std::chrono::duration<double, std::milli>(clock::now() - t0).count();
+  std::printf("[sdf] %zu prims, grid %dx%dx%d (cell %.2f), %.2f refs/cell, longest %d, built in %.2f ms\n",
+              prims.size(), gridDim.x, gridDim.y, gridDim.z, cellSize,
+              (double)total / (double)nCells, longest, ms);
+}
+
+bool SdfScene::upload() {
+  GLint maxTexels = 0;
+  glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &maxTexels);
+  const size_t need = std::max(prims.size() * 3, std::max(cells.size() / 2, cellPrims.size()));
+  if (need > (size_t)maxTexels) {
+    std::fprintf(stderr, "warn: SDF scene needs %zu buffer texels, GL_MAX_TEXTURE_BUFFER_SIZE is %d\n", need, maxTexels);
+    return false;
+  }
+
+  // never upload an empty store, texelFetch on it is undefined
+  const Prim none{};
+  const int32_t zero = 0;
+  auto fill = [](GLuint buf, GLuint tex, GLenum format, const void* data, size_t bytes, const void* fallback, size_t fbBytes) {
+    glBindBuffer(GL_TEXTURE_BUFFER, buf);
+    glBufferData(GL_TEXTURE_BUFFER, bytes ? bytes : fbBytes, bytes ? data : fallback, GL_STATIC_DRAW);
+    glBindTexture(GL_TEXTURE_BUFFER, tex);
+    glTexBuffer(GL_TEXTURE_BUFFER, format, buf);
+  };
+  fill(primBuf, primTex, GL_RGBA32F, prims.data(), prims.size() * sizeof(Prim), &none, sizeof(none));
+  fill(cellBuf, cellTex, GL_RG32I, cells.data(), cells.size() * sizeof(int32_t), &zero, sizeof(zero));
+  fill(cellPrimBuf, cellPrimTex, GL_R32I, cellPrims.data(), cellPrims.size() * sizeof(int32_t), &zero, sizeof(zero));
+  glBindTexture(GL_TEXTURE_BUFFER, 0);
+  glBindBuffer(GL_TEXTURE_BUFFER, 0);
+  return true;
+}
+
+void SdfScene::bind(GLuint program, const Locs& l) {
+  glUseProgram(program);
+  glActiveTexture(GL_TEXTURE0);
+  glBindTexture(GL_TEXTURE_BUFFER, primTex);
+  glActiveTexture(GL_TEXTURE1);
+  glBindTexture(GL_TEXTURE_BUFFER, cellTex);
+  glActiveTexture(GL_TEXTURE2);
+  glBindTexture(GL_TEXTURE_BUFFER, cellPrimTex);
+  glActiveTexture(GL_TEXTURE0);
+
+  if (l.prims     >= 0) glUniform1i(l.prims, 0);
+  if (l.cells     >= 0) glUniform1i(l.cells, 1);
+  if (l.cellPrims >= 0) glUniform1i(l.cellPrims, 2);
+  if (l.primCount >= 0) glUniform1i(l.primCount, (GLint)prims.size());
+  if (l.gridMin   >= 0) glUniform3f(l.gridMin, gridMin.x, gridMin.y, gridMin.z);
+  if (l.cellSize  >= 0) glUniform1f(l.cellSize, cellSize);
+  if (l.gridDim   >= 0) glUniform3i(l.gridDim, gridDim.x, gridDim.y, gridDim.z);
+  if (l.margin    >= 0) glUniform1f(l.margin, margin);
+  if (l.useGrid   >= 0) glUniform1i(l.useGrid, useGrid ? 1 : 0);
+  if (l.omega     >= 0) glUniform1f(l.omega, omega);
+}
+
+void SdfScene::draw(GLuint fsVAO) {
+  if (!prog || !fsVAO) return;
+  bind(prog, locs);
+  glBindVertexArray(fsVAO);
+  glDrawArrays(GL_TRIANGLES, 0, 3);
+  glBindVertexArray(0);
+  glUseProgram(0);
+}
+
+void SdfScene::benchmark(GLuint fsVAO, int width, int height) {
+  if (!statsProg || !fsVAO || width <= 0 || height <= 0) return;
+
+  static const int COUNTS[] = { 64, 256, 1024, 4096, 16384, 65536 };
+  static constexpr int FRAMES = 8;
+  struct Mode { const char* name; bool grid; float omega; };
+  static const Mode MODES[] = {
+    { "brute",      false, 1.0f  },
+    { "grid",       true,  1.0f  },
+    { "grid+relax", true,  OMEGA },
+  };
+
+  // offscreen colour + uvec2(steps, evals)
+  GLuint fbo = 0, tex[2] = {}, query = 0;
+  glGenFramebuffers(1, &fbo);
+  glGenTextures(2, tex);
+  glGenQueries(1, &query);
+  glBindTexture(GL_TEXTURE_2D, tex[0]);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  glBindTexture(GL_TEXTURE_2D, tex[1]);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_RG32UI, width, height, 0, GL_RG_INTEGER, GL_UNSIGNED_INT, nullptr);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  glBindTexture(GL_TEXTURE_2D, 0);
+
+  glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+  glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, tex[0], 0);
+  glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, tex[1], 0);
+  const GLenum bufs[2] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+  glDrawBuffers(2, bufs);
+  if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+    std::fprintf(stderr, "warn: SDF benchmark framebuffer incomplete\n");
+  } else {
+    const int keepCount = (int)prims.size();
+    const bool keepGrid = useGrid;
+    const float keepOmega = omega;
+    std::vector<GLuint> stats((size_t)width * height * 2);
+    glViewport(0, 0, width, height);
+    glBindVertexArray(fsVAO);
+
+    std::printf("[sdf] benchmark %dx%d, %d frames per row\n", width, height, FRAMES);
+    std::printf("[sdf] %7s  %-10s  %9s  %10s  %10s\n", "prims", "mode", "gpu ms", "steps/px", "evals/px");
+    for (int count : COUNTS) {
+      generate(count, seed);
+      build_grid();
+      if (!upload()) break;
+
+      for (const Mode& m : MODES) {
+        if (!m.grid && count > BRUTE_LIMIT) continue;
+        useGrid = m.grid; omega = m.omega;
+        bind(statsProg, statsLocs);
+
+        glDrawArrays(GL_TRIANGLES, 0, 3);   // warm-up, also the stats frame
+        glReadBuffer(GL_COLOR_ATTACHMENT1);
+        glReadPixels(0, 0, width, height, GL_RG_INTEGER, GL_UNSIGNED_INT, stats.data());
+
+        double gpuMs = 0.0;
+        for (int f = 0; f < FRAMES; ++f) {
+          glBeginQuery(GL_TIME_ELAPSED, query);
+          glDrawArrays(GL_TRIANGLES, 0, 3);
+          glEndQuery(GL_TIME_ELAPSED);
+          GLuint64 ns = 0;
+          glGetQueryObjectui64v(query, GL_QUERY_RESULT, &ns);
+          gpuMs += (double)ns * 1e-6;
+        }
+
+        double steps = 0.0, evals = 0.0;
+        for (size_t i = 0; i < stats.size(); i += 2) { steps += stats[i]; evals += stats[i + 1]; }
+        const double px = (double)width * height;
+        std::printf("[sdf] %7d  %-10s  %9.3f  %10.1f  %10.1f\n", count, m.name, gpuMs / FRAMES, steps / px, evals / px);
+      }
+    }
+    glReadBuffer(GL_COLOR_ATTACHMENT0);
+    glBindVertexArray(0);
+    glUseProgram(0);
+
+    useGrid = keepGrid; omega = keepOmega;
+    generate(keepCount, seed);
+    build_grid();
+    upload();
+  }
+
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  glDeleteQueries(1, &query);
+  glDeleteTextures(2, tex);
+  glDeleteFramebuffers(1, &fbo);
+}
+
+void SdfScene::shutdown() {
+  if (primTex) { glDeleteTextures(1, &primTex); primTex = 0; }
+  if (cellTex) { glDeleteTextures(1, &cellTex); cellTex = 0; }
+  if (cellPrimTex) { glDeleteTextures(1, &cellPrimTex); cellPrimTex = 0; }
+  if (primBuf) { glDeleteBuffers(1, &primBuf); primBuf = 0; }
+  if (cellBuf) { glDeleteBuffers(1, &cellBuf); cellBuf = 0; }
+  if (cellPrimBuf) { glDeleteBuffers(1, &cellPrimBuf); cellPrimBuf = 0; }
+  prims.clear(); cells.clear(); cellPrims.clear();
+}
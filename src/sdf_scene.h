@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "shader_library.h"
+
+/**
+ * =====================================================
+ * Large SDF scenes for raymarch.frag
+ * -----------------------------------------------------
+ * Primitives (spheres, boxes, round boxes) live in a texture
+ * buffer, three RGBA32F texels each. A uniform grid over their
+ * bounds is built on the CPU: every cell lists the primitives
+ * whose bounds come within `margin` of it (CSR: per cell
+ * (first, count) in an RG32I buffer, indices in an R32I one).
+ *
+ * Per march step the shader evaluates only the current cell's
+ * list. Anything not listed is at least `margin` away, so
+ * min(list distance, margin) is still a valid bound; empty
+ * cells and the space outside the grid are skipped in one step.
+ * On top of that the march is over-relaxed (uOmega) and stops
+ * on the pixel cone, see raymarch() in the shader.
+ *
+ * benchmark() times the brute-force / grid / grid + relaxation
+ * variants over growing primitive counts and logs GPU ms plus
+ * march steps and primitive evaluations per pixel.
+ * =====================================================
+ */
+struct SdfScene {
+  enum PrimType : int { Sphere = 0, Box, RoundBox };
+
+  // texels of uPrims, see primSDF() in raymarch.frag
+  struct Prim {
+    glm::vec3 center; float type;
+    glm::vec3 size;   float round;    // sphere: size.x is the radius
+    glm::vec3 albedo; float _pad;
+  };
+  static_assert(sizeof(Prim) == 48, "Prim must be three RGBA32F texels");
+
+  static constexpr int   MAX_DIM     = 128;    // grid cells per axis
+  static constexpr int   BRUTE_LIMIT = 1024;   // benchmark skips brute force above this
+  static constexpr float OMEGA       = 1.6f;   // over-relaxation factor
+
+  std::vector<Prim> prims;
+  std::vector<int32_t> cells;      // (first, count) per cell
+  std::vector<int32_t> cellPrims;
+  glm::vec3 gridMin{0.0f};
+  glm::ivec3 gridDim{1};
+  float cellSize = 1.0f, margin = 0.5f;
+  uint32_t seed = 1;
+
+  bool useGrid = true;
+  float omega = OMEGA;
+
+  GLuint prog = 0, statsProg = 0;
+  GLuint primBuf = 0, cellBuf = 0, cellPrimBuf = 0;
+  GLuint primTex = 0, cellTex = 0, cellPrimTex = 0;
+
+  struct Locs {
+    int prims = -1, cells = -1, cellPrims = -1, primCount = -1, gridMin = -1;
+    int cellSize = -1, gridDim = -1, margin = -1, useGrid = -1, omega = -1;
+  };
+  Locs locs, statsLocs;
+
+  bool init(ShaderLibrary& lib, int count, uint32_t seed);
+  void generate(int count, uint32_t seed);
+  void build_grid();
+  bool upload();
+
+  // FrameData must be committed
+  void draw(GLuint fsVAO);
+  void benchmark(GLuint fsVAO, int width, int height);
+
+  void shutdown();
+
+  void bind(GLuint program, const Locs& l);
+};
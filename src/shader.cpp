@@ -33,11 +33,32 @@ GLuint link_program(GLuint vs, GLuint fs, std::string* err) {
     return p;
 }
 
-GLuint compile_shader_file(GLenum type, const char* filepath_rel, std::string* err) {
+GLuint link_program(GLuint vs, GLuint gs, GLuint fs, std::string* err) {
+    GLuint p = glCreateProgram();
+    glAttachShader(p, vs); glAttachShader(p, gs); glAttachShader(p, fs);
+    glLinkProgram(p);
+    glDetachShader(p, vs); glDetachShader(p, gs); glDetachShader(p, fs);
+    glDeleteShader(vs); glDeleteShader(gs); glDeleteShader(fs);
+    GLint ok = 0; glGetProgramiv(p, GL_LINK_STATUS, &ok);
+    if (!ok) {
+        char log[1024]; GLsizei n=0; glGetProgramInfoLog(p, 1024, &n, log);
+        if (err) *err = std::string(log, n);
+        glDeleteProgram(p);
+        return 0;
+    }
+    return p;
+}
+
+GLuint compile_shader_file(GLenum type, const char* filepath_rel, std::string* err, const std::string& defines) {
     std::string src; 
     if(!AssetLoader::instance().read_text(filepath_rel, src)) {
         if (err) *err = std::string("Could not read life: ") + filepath_rel;
         return 0;
     }
+    if (!defines.empty()) {
+        // #version has to stay the first line, so the defines go right after it
+        const size_t eol = src.find('\n');
+        src.insert(eol == std::string::npos ? src.size() : eol + 1, defines);
+    }
     return compile_shader(type, src.c_str(), err);
 }
\ No newline at end of file
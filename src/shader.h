@@ -9,4 +9,6 @@ struct ShaderProgram {
 
 GLuint compile_shader(GLenum type, const char* src, std::string* err = nullptr); 
 GLuint link_program(GLuint vs, GLuint fs, std::string* err = nullptr);
-GLuint compile_shader_file(GLenum type, const char* filepath_rel, std::string* err = nullptr);
\ No newline at end of file
+GLuint link_program(GLuint vs, GLuint gs, GLuint fs, std::string* err = nullptr);
+// `defines` (e.g. "#define RAY_STATS\n") is spliced in right after the #version line.
+GLuint compile_shader_file(GLenum type, const char* filepath_rel, std::string* err = nullptr, const std::string& defines = "");
\ No newline at end of file
@@ -8,14 +8,14 @@ void ShaderLibrary::shutdown() {
     progs.clear();
 }
 
-const ShaderProgram& ShaderLibrary::get_from_files(const std::string& name, const std::string& vs_rel, const std::string& fs_rel) {
+const ShaderProgram& ShaderLibrary::get_from_files(const std::string& name, const std::string& vs_rel, const std::string& fs_rel, const std::string& defines) {
     auto it = progs.find(name); 
     if (it != progs.end()) return it->second;
 
     std::string err; 
-    GLuint vs = compile_shader_file(GL_VERTEX_SHADER,   vs_rel.c_str(), &err);
+    GLuint vs = compile_shader_file(GL_VERTEX_SHADER,   vs_rel.c_str(), &err, defines);
     if (!vs) std::fprintf(stderr, "[%s] VS file error: %s\n", name.c_str(), err.c_str());
-    GLuint fs = compile_shader_file(GL_FRAGMENT_SHADER, fs_rel.c_str(), &err);
+    GLuint fs = compile_shader_file(GL_FRAGMENT_SHADER, fs_rel.c_str(), &err, defines);
     if (!fs) std::fprintf(stderr, "[%s] FS file error: %s\n", name.c_str(), err.c_str());
 
     GLuint prog = 0;
@@ -32,6 +32,34 @@ const ShaderProgram& ShaderLibrary::get_from_files(const std::string& name, cons
    return ins->second;
 }
 
+const ShaderProgram& ShaderLibrary::get_from_files_gs(const std::string& name, const std::string& vs_rel, const std::string& gs_rel,
+                                                      const std::string& fs_rel, const std::string& defines) {
+    auto it = progs.find(name); 
+    if (it != progs.end()) return it->second;
+
+    std::string err; 
+    GLuint vs = compile_shader_file(GL_VERTEX_SHADER,   vs_rel.c_str(), &err, defines);
+    if (!vs) std::fprintf(stderr, "[%s] VS file error: %s\n", name.c_str(), err.c_str());
+    GLuint gs = compile_shader_file(GL_GEOMETRY_SHADER, gs_rel.c_str(), &err, defines);
+    if (!gs) std::fprintf(stderr, "[%s] GS file error: %s\n", name.c_str(), err.c_str());
+    GLuint fs = compile_shader_file(GL_FRAGMENT_SHADER, fs_rel.c_str(), &err, defines);
+    if (!fs) std::fprintf(stderr, "[%s] FS file error: %s\n", name.c_str(), err.c_str());
+
+    GLuint prog = 0;
+    if (vs && gs && fs) {
+        prog = link_program(vs, gs, fs, &err); 
+        if (!prog) std::fprintf(stderr, "[%s] Link error: %s\n", name.c_str(), err.c_str());
+    } else {
+        if (vs) glDeleteShader(vs); 
+        if (gs) glDeleteShader(gs); 
+        if (fs) glDeleteShader(fs); 
+    }
+
+    ShaderProgram sp{prog};
+    auto [ins, _] = progs.emplace(name, sp);
+    return ins->second;
+}
+
 const ShaderProgram& ShaderLibrary::get_raymarch() {
     auto it = progs.find("raymarch");
     if (it != progs.end()) return it->second;
@@ -44,6 +72,61 @@ const ShaderProgram& ShaderLibrary::get_raymarch() {
     return ShaderProgram();
 }
 
+/* Same tracer, compiled with per-pixel cost counters (see RayStats) */
+const ShaderProgram& ShaderLibrary::get_raymarch_stats(bool atomics, bool atomic_ops, int max_steps) {
+    // one cache entry per variant, so a failed compile doesn't shadow the simpler ones
+    std::string name = "raymarch_stats";
+    std::string defines = "#define RAY_STATS\n#define N_STEPS " + std::to_string(max_steps) + "\n";
+    if (atomics)    { name += "_atomics"; defines += "#define RAY_STATS_ATOMICS\n"; }
+    if (atomic_ops) { name += "_ops";     defines += "#define RAY_STATS_ATOMIC_OPS\n"; }
+    return get_from_files(name, "shaders/raymarch.vert", "shaders/animated_blackhole.frag", defines);
+}
+
+const ShaderProgram& ShaderLibrary::get_ray_stats_view() {
+    return get_from_files("ray_stats_view", "shaders/raymarch.vert", "shaders/ray_stats.frag");
+}
+
+/* Same tracer, every view of a MultiView pass in one draw (one layer per view) */
+const ShaderProgram& ShaderLibrary::get_raymarch_multiview() {
+    return get_from_files_gs("raymarch_multiview", "shaders/raymarch.vert", "shaders/multiview.geom",
+                             "shaders/animated_blackhole.frag", "#define MULTIVIEW\n");
+}
+
+const ShaderProgram& ShaderLibrary::get_equirect_resolve() {
+    return get_from_files("equirect", "shaders/raymarch.vert", "shaders/equirect.frag");
+}
+
+const ShaderProgram& ShaderLibrary::get_particles() {
+    return get_from_files("particles", "shaders/particles.vert", "shaders/particles.frag");
+}
+
+const ShaderProgram& ShaderLibrary::get_raymarch_warp() {
+    return get_from_files("raymarch_warp", "shaders/raymarch.vert", "shaders/animated_blackhole.frag", "#define WARP_MAP\n");
+}
+
+const ShaderProgram& ShaderLibrary::get_lens_env() {
+    return get_from_files("lens_env", "shaders/lens_env.vert", "shaders/lens_env.frag");
+}
+
+const ShaderProgram& ShaderLibrary::get_lens_compose() {
+    return get_from_files("lens_compose", "shaders/raymarch.vert", "shaders/lens_compose.frag");
+}
+
+/* SDF primitive scene (raymarch.frag); stats adds steps / evaluations per pixel */
+const ShaderProgram& ShaderLibrary::get_sdf_scene(bool stats) {
+    if (stats) return get_from_files("sdf_scene_stats", "shaders/raymarch.vert", "shaders/raymarch.frag", "#define SDF_STATS\n");
+    return get_from_files("sdf_scene", "shaders/raymarch.vert", "shaders/raymarch.frag");
+}
+
+/* Static (non-animated) tracer, the input to TemporalAccum */
+const ShaderProgram& ShaderLibrary::get_blackhole_static() {
+    return get_from_files("blackhole", "shaders/raymarch.vert", "shaders/blackhole.frag");
+}
+
+const ShaderProgram& ShaderLibrary::get_temporal_accum() {
+    return get_from_files("temporal_accum", "shaders/raymarch.vert", "shaders/temporal_accum.frag");
+}
+
 /* Flat Color Example */
 const ShaderProgram& ShaderLibrary::get_flat_color() {
     auto it = progs.find("flat");
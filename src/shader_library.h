@@ -11,6 +11,19 @@ struct ShaderLibrary {
 
   const ShaderProgram& get_flat_color();
   const ShaderProgram& get_raymarch();
+  const ShaderProgram& get_raymarch_stats(bool atomics, bool atomic_ops, int max_steps);
+  const ShaderProgram& get_ray_stats_view();
+  const ShaderProgram& get_raymarch_multiview();
+  const ShaderProgram& get_equirect_resolve();
+  const ShaderProgram& get_particles();
+  const ShaderProgram& get_raymarch_warp();
+  const ShaderProgram& get_lens_env();
+  const ShaderProgram& get_lens_compose();
+  const ShaderProgram& get_sdf_scene(bool stats);
+  const ShaderProgram& get_blackhole_static();
+  const ShaderProgram& get_temporal_accum();
 
-  const ShaderProgram& get_from_files(const std::string& name, const std::string& vs_rel, const std::string& fs_rel);
+  const ShaderProgram& get_from_files(const std::string& name, const std::string& vs_rel, const std::string& fs_rel, const std::string& defines = "");
+  const ShaderProgram& get_from_files_gs(const std::string& name, const std::string& vs_rel, const std::string& gs_rel,
+                                         const std::string& fs_rel, const std::string& defines);
 };
\ No newline at end of file
@@ -0,0 +1,152 @@
+#include "temporal_accum.h"
+#include "frame_ring.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+float TemporalAccum::halton(int index, int base) {
+  float f = 1.0f, r = 0.0f;
+  for (int i = index; i > 0; i /= base) {
+    f /= (float)base;
+    r += f * (float)(i % base);
+  }
+  return r;
+}
+
+bool TemporalAccum::init(ShaderLibrary& lib) {
+  traceProg = lib.get_blackhole_static().id;
+  accumProg = lib.get_temporal_accum().id;
+  if (!traceProg || !accumProg) return false;
+
+  FrameRing::bind_block(traceProg);
+
+  uCurrentLoc  = glGetUniformLocation(accumProg, "uCurrent");
+  uHistoryLoc  = glGetUniformLocation(accumProg, "uHistory");
+  uCurInvVPLoc = glGetUniformLocation(accumProg, "uCurInvVP");
+  uPrevVPLoc   = glGetUniformLocation(accumProg, "uPrevVP");
+  uModeLoc     = glGetUniformLocation(accumProg, "uMode");
+  uMaxCountLoc = glGetUniformLocation(accumProg, "uMaxCount");
+
+  glGenFramebuffers(1, &curFBO);
+  glGenTextures(1, &curTex);
+  glGenFramebuffers(2, histFBO);
+  glGenTextures(2, histTex);
+  valid = false;
+  return curFBO && curTex && histFBO[0] && histFBO[1] && histTex[0] && histTex[1];
+}
+
+static bool attach(GLuint fbo, GLuint tex, GLenum format, int w, int h, GLint filter) {
+  glBindTexture(GL_TEXTURE_2D, tex);
+  glTexImage2D(GL_TEXTURE_2D, 0, format, w, h, 0, GL_RGBA, GL_FLOAT, nullptr);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glBindTexture(GL_TEXTURE_2D, 0);
+
+  glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+  glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, tex, 0);
+  const bool ok = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  return ok;
+}
+
+glm::mat4 TemporalAccum::jittered_inv_vp(const Camera& cam, int width, int height) {
+  // index from 1: Halton(0) is the pixel corner for both bases
+  const int i = frameIndex++ % MAX_SAMPLES + 1;
+  const glm::vec2 px(halton(i, 2) - 0.5f, halton(i, 3) - 0.5f);
+  jitterNDC = 2.0f * px / glm::vec2((float)std::max(width, 1), (float)std::max(height, 1));
+
+  // the tracer's pixel n then shoots the unjittered ray of n - jitterNDC
+  return cam.getInvViewProj() * glm::translate(glm::mat4(1.0f), glm::vec3(-jitterNDC, 0.0f));
+}
+
+void TemporalAccum::draw(const Camera& cam, GLuint fsVAO, int width, int height, double time) {
+  if (!traceProg || !accumProg || !fsVAO || width <= 0 || height <= 0) return;
+
+  if (width != fbWidth || height != fbHeight) {
+    // the sample is HDR but never re-read after folding in; the history needs full float
+    bool ok = attach(curFBO, curTex, GL_RGBA16F, width, height, GL_NEAREST);
+    for (int k = 0; k < 2; ++k) ok = attach(histFBO[k], histTex[k], GL_RGBA32F, width, height, GL_LINEAR) && ok;
+    if (!ok) {
+      std::fprintf(stderr, "warn: accumulation framebuffer incomplete\n");
+      return;
+    }
+    fbWidth = width; fbHeight = height;
+    valid = false;
+  }
+
+  // how fast has the camera moved since the history was written?
+  const float dt     = (float)std::clamp(time - prevTime, 1e-3, 0.25);
+  const float moved  = glm::length(cam.position - prevPos);
+  const float turned = std::acos(std::clamp(glm::dot(cam.front, prevFront), -1.0f, 1.0f));
+  int mode = 2;
+  int cap = MAX_SAMPLES;
+  if (!valid || cam.aspect != prevAspect || moved > RESTART_MOVE * dt || turned > RESTART_TURN * dt) {
+    mode = 0;
+  } else if (moved == 0.0f && cam.front == prevFront) {
+    mode = 1;
+  } else {
+    // reprojected: every frame resamples the history bilinearly
+    cap = MOVING_SAMPLES;
+  }
+  samples = (mode == 0) ? 1 : std::min(samples, cap) + 1;
+
+  // 1. one jittered sample per pixel
+  glBindFramebuffer(GL_FRAMEBUFFER, curFBO);
+  glViewport(0, 0, width, height);
+  glUseProgram(traceProg);
+  glBindVertexArray(fsVAO);
+  glDrawArrays(GL_TRIANGLES, 0, 3);
+
+  // 2. fold it into the other history buffer
+  const int next = 1 - latest;
+  const glm::mat4 VP = cam.getViewProj();
+  const glm::mat4 invVP = cam.getInvViewProj();
+  glBindFramebuffer(GL_FRAMEBUFFER, histFBO[next]);
+  glUseProgram(accumProg);
+  glActiveTexture(GL_TEXTURE0);
+  glBindTexture(GL_TEXTURE_2D, curTex);
+  glActiveTexture(GL_TEXTURE1);
+  glBindTexture(GL_TEXTURE_2D, histTex[latest]);
+  if (uCurrentLoc  >= 0) glUniform1i(uCurrentLoc, 0);
+  if (uHistoryLoc  >= 0) glUniform1i(uHistoryLoc, 1);
+  if (uCurInvVPLoc >= 0) glUniformMatrix4fv(uCurInvVPLoc, 1, GL_FALSE, glm::value_ptr(invVP));
+  if (uPrevVPLoc   >= 0) glUniformMatrix4fv(uPrevVPLoc, 1, GL_FALSE, glm::value_ptr(prevVP));
+  if (uModeLoc     >= 0) glUniform1i(uModeLoc, mode);
+  if (uMaxCountLoc >= 0) glUniform1f(uMaxCountLoc, (float)(cap - 1));
+  glDrawArrays(GL_TRIANGLES, 0, 3);
+  glBindVertexArray(0);
+
+  glBindTexture(GL_TEXTURE_2D, 0);
+  glActiveTexture(GL_TEXTURE0);
+  glBindTexture(GL_TEXTURE_2D, 0);
+  glUseProgram(0);
+  latest = next;
+
+  // 3. show it
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, histFBO[latest]);
+  glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+  glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+  valid = true;
+  prevVP = VP;
+  prevPos = cam.position;
+  prevFront = cam.front;
+  prevAspect = cam.aspect;
+  prevTime = time;
+}
+
+void TemporalAccum::shutdown() {
+  if (curTex) { glDeleteTextures(1, &curTex); curTex = 0; }
+  if (histTex[0]) { glDeleteTextures(2, histTex); histTex[0] = histTex[1] = 0; }
+  if (curFBO) { glDeleteFramebuffers(1, &curFBO); curFBO = 0; }
+  if (histFBO[0]) { glDeleteFramebuffers(2, histFBO); histFBO[0] = histFBO[1] = 0; }
+  fbWidth = fbHeight = 0;
+  valid = false;
+}
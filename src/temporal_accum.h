@@ -0,0 +1,75 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "shader_library.h"
+#include "camera.h"
+
+/**
+ * =====================================================
+ * Temporal progressive accumulation
+ * -----------------------------------------------------
+ * The static tracer (blackhole.frag) gives the same image
+ * every frame for a still camera, so instead of
+ * supersampling each frame, one jittered sample per pixel
+ * is traced and folded into a float history:
+ *
+ *   jitter:   Halton(2,3) sub-pixel offset, applied by the
+ *             caller through FrameData's invVP
+ *             (jittered_inv_vp), so the tracer is unchanged
+ *   history:  RGBA32F ping-pong, rgb = running mean,
+ *             a = samples, capped at MAX_SAMPLES
+ *   motion:   unchanged view   -> keep accumulating
+ *             slow rotation /  -> reproject by ray direction
+ *             translation         (bilinear, so the history is
+ *                                 capped at MOVING_SAMPLES to
+ *                                 keep the resampling blur from
+ *                                 compounding)
+ *             anything faster  -> restart
+ *             Speeds are per second, so the split does not depend
+ *             on the frame rate.
+ *
+ * A still camera converges to MAX_SAMPLES samples per pixel
+ * at the cost of one traced sample per frame.
+ * =====================================================
+ */
+struct TemporalAccum {
+  static constexpr int   MAX_SAMPLES    = 1024;
+  static constexpr int   MOVING_SAMPLES = 4;
+  static constexpr float RESTART_MOVE   = 3.0f;   // scene units per second
+  static constexpr float RESTART_TURN   = 6.0f;   // radians per second
+
+  GLuint traceProg = 0, accumProg = 0;
+  GLuint curFBO = 0, curTex = 0;
+  GLuint histFBO[2] = {}, histTex[2] = {};
+  int latest = 0;                 // histTex[latest] holds the current result
+  int fbWidth = 0, fbHeight = 0;
+
+  int frameIndex = 0;             // position in the Halton sequence
+  int samples = 0;                // history length at a still pixel, for the log
+  glm::vec2 jitterNDC{0.0f};
+  bool valid = false;
+  glm::mat4 prevVP{1.0f};
+  glm::vec3 prevPos{0.0f}, prevFront{0.0f, 0.0f, -1.0f};
+  float prevAspect = 0.0f;
+  double prevTime = 0.0;
+
+  int uCurrentLoc = -1, uHistoryLoc = -1, uCurInvVPLoc = -1, uPrevVPLoc = -1;
+  int uModeLoc = -1, uMaxCountLoc = -1;
+
+  bool init(ShaderLibrary& lib);
+
+  // this frame's jittered inverse VP for FrameData; advances the sequence
+  glm::mat4 jittered_inv_vp(const Camera& cam, int width, int height);
+
+  // trace one sample, fold it into the history and show the result;
+  // FrameData must be committed with jittered_inv_vp(). time is engine
+  // seconds, for the motion speeds.
+  void draw(const Camera& cam, GLuint fsVAO, int width, int height, double time);
+
+  void reset() { valid = false; }
+  void shutdown();
+
+  static float halton(int index, int base);
+};
@@ -0,0 +1,213 @@
+#include "warp_lens.h"
+#include "frame_ring.h"
+
+#include <cstdio>
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+// forward / up per GL cubemap face (+X -X +Y -Y +Z -Z), as texture(samplerCube) expects
+static const glm::vec3 GL_CUBE_FACES[6][2] = {
+  { { 1, 0, 0}, {0,-1, 0} }, { {-1, 0, 0}, {0,-1, 0} },
+  { { 0, 1, 0}, {0, 0, 1} }, { { 0,-1, 0}, {0, 0,-1} },
+  { { 0, 0, 1}, {0,-1, 0} }, { { 0, 0,-1}, {0,-1, 0} },
+};
+
+static void set_sampling(GLenum target, GLint filter) {
+  glTexParameteri(target, GL_TEXTURE_MIN_FILTER, filter);
+  glTexParameteri(target, GL_TEXTURE_MAG_FILTER, filter);
+  glTexParameteri(target, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(target, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glTexParameteri(target, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+}
+
+bool WarpLens::init(ShaderLibrary& lib) {
+  warpProg    = lib.get_raymarch_warp().id;
+  envProg     = lib.get_lens_env().id;
+  composeProg = lib.get_lens_compose().id;
+  if (!warpProg || !envProg || !composeProg) return false;
+
+  FrameRing::bind_block(warpProg);
+  FrameRing::bind_block(composeProg);
+
+  uEnvModelLoc = glGetUniformLocation(envProg, "uModel");
+  uEnvVPLoc    = glGetUniformLocation(envProg, "uVP");
+  uWarpPosLoc  = glGetUniformLocation(composeProg, "uWarpPos");
+  uWarpDirLoc  = glGetUniformLocation(composeProg, "uWarpDir");
+  uWarpEmitLoc = glGetUniformLocation(composeProg, "uWarpEmit");
+  uWarpDisk0Loc = glGetUniformLocation(composeProg, "uWarpDisk0");
+  uWarpDisk1Loc = glGetUniformLocation(composeProg, "uWarpDisk1");
+  uEnvColorLoc = glGetUniformLocation(composeProg, "uEnvColor");
+  uEnvDistLoc  = glGetUniformLocation(composeProg, "uEnvDist");
+
+  // environment cube: filtered colour, nearest distance (no blending across silhouettes)
+  glGenTextures(1, &envColorTex);
+  glBindTexture(GL_TEXTURE_CUBE_MAP, envColorTex);
+  for (int f = 0; f < 6; ++f)
+    glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + f, 0, GL_RGBA8, ENV_SIZE, ENV_SIZE, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+  set_sampling(GL_TEXTURE_CUBE_MAP, GL_LINEAR);
+
+  glGenTextures(1, &envDistTex);
+  glBindTexture(GL_TEXTURE_CUBE_MAP, envDistTex);
+  for (int f = 0; f < 6; ++f)
+    glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + f, 0, GL_R32F, ENV_SIZE, ENV_SIZE, 0, GL_RED, GL_FLOAT, nullptr);
+  set_sampling(GL_TEXTURE_CUBE_MAP, GL_NEAREST);
+  glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+
+  glGenRenderbuffers(1, &envDepthRB);
+  glBindRenderbuffer(GL_RENDERBUFFER, envDepthRB);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, ENV_SIZE, ENV_SIZE);
+  glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+  glGenFramebuffers(1, &envFBO);
+  glGenFramebuffers(1, &warpFBO);
+  glGenTextures(WARP_TARGETS, warpTex);
+
+  warpValid = false;
+  rebuilds = 0;
+  return envColorTex && envDistTex && envDepthRB && envFBO && warpFBO && warpTex[0];
+}
+
+void WarpLens::render_env(GLuint meshVAO, GLsizei indexCount, const glm::mat4* models, int count) {
+  if (!envProg || !envFBO) return;
+
+  const glm::mat4 P = glm::perspective(glm::radians(90.0f), 1.0f, ENV_NEAR, ENV_FAR);
+  const GLenum bufs[2] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+  const GLfloat clearColor[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+  const GLfloat clearDist[4]  = { 0.0f, 0.0f, 0.0f, 0.0f };
+
+  glBindFramebuffer(GL_FRAMEBUFFER, envFBO);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, envDepthRB);
+  glDrawBuffers(2, bufs);
+  glViewport(0, 0, ENV_SIZE, ENV_SIZE);
+  glDisable(GL_CULL_FACE);   // face matrices mirror the winding
+
+  glUseProgram(envProg);
+  glBindVertexArray(meshVAO);
+  for (int f = 0; f < 6; ++f) {
+    const GLenum face = GL_TEXTURE_CUBE_MAP_POSITIVE_X + f;
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, face, envColorTex, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, face, envDistTex, 0);
+    if (f == 0 && glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+      std::fprintf(stderr, "warn: lens environment framebuffer incomplete\n");
+      break;
+    }
+
+    glClearBufferfv(GL_COLOR, 0, clearColor);
+    glClearBufferfv(GL_COLOR, 1, clearDist);
+    glClear(GL_DEPTH_BUFFER_BIT);
+
+    const glm::mat4 VP = P * glm::lookAt(glm::vec3(0.0f), GL_CUBE_FACES[f][0], GL_CUBE_FACES[f][1]);
+    if (uEnvVPLoc >= 0) glUniformMatrix4fv(uEnvVPLoc, 1, GL_FALSE, glm::value_ptr(VP));
+    for (int i = 0; i < count; ++i) {
+      if (uEnvModelLoc >= 0) glUniformMatrix4fv(uEnvModelLoc, 1, GL_FALSE, glm::value_ptr(models[i]));
+      glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, 0);
+    }
+  }
+  glBindVertexArray(0);
+  glUseProgram(0);
+
+  glEnable(GL_CULL_FACE);
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+bool WarpLens::update_warp(const glm::mat4& invVP, const glm::vec3& camPos, int w, int h, GLuint fsVAO) {
+  if (!warpProg || !fsVAO || w <= 0 || h <= 0) return false;
+
+  if (w != warpW || h != warpH) {
+    // exit positions and disk hits need full float; direction and emission are fine at half
+    const GLenum formats[WARP_TARGETS] = { GL_RGBA32F, GL_RGBA16F, GL_RGBA16F, GL_RGBA32F, GL_RGBA32F };
+    for (int i = 0; i < WARP_TARGETS; ++i) {
+      glBindTexture(GL_TEXTURE_2D, warpTex[i]);
+      glTexImage2D(GL_TEXTURE_2D, 0, formats[i], w, h, 0, GL_RGBA, GL_FLOAT, nullptr);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, warpFBO);
+    for (int i = 0; i < WARP_TARGETS; ++i)
+      glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_2D, warpTex[i], 0);
+    const bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    if (!complete) {
+      std::fprintf(stderr, "warn: warp map framebuffer incomplete\n");
+      return false;
+    }
+    warpW = w; warpH = h;
+    warpValid = false;
+  }
+
+  // the disk animation is evaluated in compose, so a still view needs no trace
+  if (warpValid && invVP == warpInvVP && camPos == warpCamPos) return true;
+
+  GLenum bufs[WARP_TARGETS];
+  for (int i = 0; i < WARP_TARGETS; ++i) bufs[i] = GL_COLOR_ATTACHMENT0 + i;
+  glBindFramebuffer(GL_FRAMEBUFFER, warpFBO);
+  glDrawBuffers(WARP_TARGETS, bufs);
+  glViewport(0, 0, w, h);
+
+  glUseProgram(warpProg);
+  glBindVertexArray(fsVAO);
+  glDrawArrays(GL_TRIANGLES, 0, 3);
+  glBindVertexArray(0);
+  glUseProgram(0);
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+  warpInvVP = invVP;
+  warpCamPos = camPos;
+  warpValid = true;
+  ++rebuilds;
+  return true;
+}
+
+void WarpLens::compose(GLuint fsVAO) {
+  if (!composeProg || !fsVAO || !warpValid) return;
+
+  // units 0..WARP_TARGETS-1: warp map, then the two env cubes
+  const GLint envUnit = WARP_TARGETS;
+  glUseProgram(composeProg);
+  for (int i = 0; i < WARP_TARGETS; ++i) {
+    glActiveTexture(GL_TEXTURE0 + i);
+    glBindTexture(GL_TEXTURE_2D, warpTex[i]);
+  }
+  glActiveTexture(GL_TEXTURE0 + envUnit);
+  glBindTexture(GL_TEXTURE_CUBE_MAP, envColorTex);
+  glActiveTexture(GL_TEXTURE0 + envUnit + 1);
+  glBindTexture(GL_TEXTURE_CUBE_MAP, envDistTex);
+
+  if (uWarpPosLoc   >= 0) glUniform1i(uWarpPosLoc, 0);
+  if (uWarpDirLoc   >= 0) glUniform1i(uWarpDirLoc, 1);
+  if (uWarpEmitLoc  >= 0) glUniform1i(uWarpEmitLoc, 2);
+  if (uWarpDisk0Loc >= 0) glUniform1i(uWarpDisk0Loc, 3);
+  if (uWarpDisk1Loc >= 0) glUniform1i(uWarpDisk1Loc, 4);
+  if (uEnvColorLoc  >= 0) glUniform1i(uEnvColorLoc, envUnit);
+  if (uEnvDistLoc   >= 0) glUniform1i(uEnvDistLoc, envUnit + 1);
+
+  glBindVertexArray(fsVAO);
+  glDrawArrays(GL_TRIANGLES, 0, 3);
+  glBindVertexArray(0);
+
+  glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+  glActiveTexture(GL_TEXTURE0 + envUnit);
+  glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+  for (int i = 0; i < WARP_TARGETS; ++i) {
+    glActiveTexture(GL_TEXTURE0 + i);
+    glBindTexture(GL_TEXTURE_2D, 0);
+  }
+  glUseProgram(0);
+}
+
+void WarpLens::shutdown() {
+  if (warpTex[0]) {
+    glDeleteTextures(WARP_TARGETS, warpTex);
+    for (GLuint& t : warpTex) t = 0;
+  }
+  if (envColorTex) { glDeleteTextures(1, &envColorTex); envColorTex = 0; }
+  if (envDistTex) { glDeleteTextures(1, &envDistTex); envDistTex = 0; }
+  if (envDepthRB) { glDeleteRenderbuffers(1, &envDepthRB); envDepthRB = 0; }
+  if (warpFBO) { glDeleteFramebuffers(1, &warpFBO); warpFBO = 0; }
+  if (envFBO) { glDeleteFramebuffers(1, &envFBO); envFBO = 0; }
+  warpW = warpH = 0;
+  warpValid = false;
+}
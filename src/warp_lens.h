@@ -0,0 +1,76 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "shader_library.h"
+
+/**
+ * =====================================================
+ * Lensed rasterized objects via a warp map
+ * -----------------------------------------------------
+ * Meshes are never traced. Instead:
+ *
+ *   1. env:     rasterize the scene unlensed into a cubemap
+ *               centred on the hole (colour + coverage, and
+ *               the distance from the hole), every frame.
+ *   2. warp:    the tracer (animated_blackhole.frag with
+ *               WARP_MAP) writes, per pixel, where the ray
+ *               finally leaves the lensing sphere (R_LENS), its
+ *               direction there, whether it got out at all, the
+ *               static (corona) emission picked up on the way and,
+ *               for the first two disk crossings, where the ray
+ *               met the disk (radius, azimuth, photon direction,
+ *               weight). Only redone when the camera or the size
+ *               changes.
+ *   3. compose: per pixel, follow the straight exit ray into the
+ *               distance cubemap (a couple of parallax steps), add
+ *               the static emission and evaluate the animated disk
+ *               at the stored crossings for this frame's time.
+ *
+ * So the geodesics are paid for once per camera pose and a still
+ * camera or moving objects only cost the cube raster and a few
+ * texture fetches plus the disk's closed-form emission per pixel.
+ * Objects belong outside LENS_RADIUS; inside it they would need
+ * the curved path.
+ * =====================================================
+ */
+struct WarpLens {
+  static constexpr float RS          = 0.8f;
+  static constexpr float LENS_RADIUS = 12.0f * RS;   // R_LENS in the shaders
+  static constexpr int   ENV_SIZE    = 512;          // cube face, pixels
+  static constexpr float ENV_NEAR    = 0.1f, ENV_FAR = 200.0f;
+  static constexpr int   WARP_TARGETS = 5;            // MRT outputs of the WARP_MAP tracer
+
+  GLuint warpProg = 0, envProg = 0, composeProg = 0;
+
+  // warp map: 0 = exit position + transmittance, 1 = exit direction + disk weight 0,
+  // 2 = static emission + disk weight 1, 3 / 4 = disk crossing 0 / 1
+  GLuint warpFBO = 0, warpTex[WARP_TARGETS] = {};
+  int warpW = 0, warpH = 0;
+  bool warpValid = false;
+  glm::mat4 warpInvVP{1.0f};
+  glm::vec3 warpCamPos{0.0f};
+  int rebuilds = 0;   // warp traces since init, for the log
+
+  // unlensed environment
+  GLuint envFBO = 0, envColorTex = 0, envDistTex = 0, envDepthRB = 0;
+
+  int uEnvModelLoc = -1, uEnvVPLoc = -1;
+  int uWarpPosLoc = -1, uWarpDirLoc = -1, uWarpEmitLoc = -1, uWarpDisk0Loc = -1, uWarpDisk1Loc = -1;
+  int uEnvColorLoc = -1, uEnvDistLoc = -1;
+
+  bool init(ShaderLibrary& lib);
+
+  // rasterize count instances of an indexed mesh (aPos at 0, aCol at 1) into the cube
+  void render_env(GLuint meshVAO, GLsizei indexCount, const glm::mat4* models, int count);
+
+  // re-trace the warp map if the view differs from the last one; FrameData must be committed
+  bool update_warp(const glm::mat4& invVP, const glm::vec3& camPos, int w, int h, GLuint fsVAO);
+
+  // resample the environment through the warp map into the bound framebuffer
+  void compose(GLuint fsVAO);
+
+  void invalidate() { warpValid = false; }
+  void shutdown();
+};
@@ -0,0 +1,65 @@
+#include "worker_pool.h"
+
+void WorkerPool::start(unsigned workers) {
+  stop();
+  quit = false;
+  for (unsigned i = 0; i < workers; ++i) threads.emplace_back([this] { worker_loop(); });
+}
+
+void WorkerPool::run(size_t n, size_t chunk_size, const std::function<void(size_t, size_t)>& fn) {
+  if (n == 0) return;
+  if (threads.empty() || n <= chunk_size) { fn(0, n); return; }
+
+  {
+    std::lock_guard<std::mutex> lock(m);
+    job = fn;
+    count = n;
+    chunk = chunk_size ? chunk_size : 1;
+    next.store(0, std::memory_order_relaxed);
+    busy = threads.size();
+    ++generation;
+  }
+  wake.notify_all();
+
+  drain();
+
+  std::unique_lock<std::mutex> lock(m);
+  done.wait(lock, [this] { return busy == 0; });
+  job = nullptr;
+}
+
+void WorkerPool::drain() {
+  for (;;) {
+    const size_t begin = next.fetch_add(chunk, std::memory_order_relaxed);
+    if (begin >= count) return;
+    const size_t end = (begin + chunk < count) ? begin + chunk : count;
+    job(begin, end);
+  }
+}
+
+void WorkerPool::worker_loop() {
+  uint64_t seen = 0;
+  for (;;) {
+    {
+      std::unique_lock<std::mutex> lock(m);
+      wake.wait(lock, [&] { return quit || generation != seen; });
+      if (quit) return;
+      seen = generation;
+    }
+
+    drain();
+
+    std::lock_guard<std::mutex> lock(m);
+    if (--busy == 0) done.notify_one();
+  }
+}
+
+void WorkerPool::stop() {
+  {
+    std::lock_guard<std::mutex> lock(m);
+    quit = true;
+  }
+  wake.notify_all();
+  for (std::thread& t : threads) t.join();
+  threads.clear();
+}
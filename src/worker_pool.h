@@ -0,0 +1,43 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Minimal fork-join pool for chunked loops.
+ *
+ *   pool.run(n, chunk, [&](size_t begin, size_t end) { ... });
+ *
+ * The caller takes chunks too and run() returns once every chunk
+ * is done. Which thread gets which chunk is not fixed, so jobs must
+ * only write state owned by their own range.
+ */
+struct WorkerPool {
+  std::vector<std::thread> threads;
+  std::mutex m;
+  std::condition_variable wake, done;
+
+  std::function<void(size_t, size_t)> job;
+  size_t count = 0, chunk = 1;
+  std::atomic<size_t> next{0};
+  size_t busy = 0;            // workers still inside the current job
+  uint64_t generation = 0;    // bumped per run() so workers see new jobs
+  bool quit = false;
+
+  ~WorkerPool() { stop(); }
+
+  void start(unsigned workers);
+  void run(size_t n, size_t chunk_size, const std::function<void(size_t, size_t)>& fn);
+  void stop();
+
+  size_t size() const { return threads.size() + 1; }   // including the caller
+
+  void drain();
+  void worker_loop();
+};